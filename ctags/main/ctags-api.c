@@ -88,6 +88,23 @@ extern int ctagsGetNamedLang(const char *name)
 }
 
 
+extern int ctagsGetFileLang(const char *fileName)
+{
+	static bool mapsInstalled = false;
+
+	/* Geany detects filetypes itself, so the extension maps and aliases are
+	 * only set up once they are actually needed */
+	if (!mapsInstalled)
+	{
+		installLanguageMapDefaults();
+		installLanguageAliasesDefaults();
+		mapsInstalled = true;
+	}
+
+	return getFileLanguage(fileName);
+}
+
+
 extern const char *ctagsGetLangKinds(int lang)
 {
 	const parserDefinition *def = getParserDefinition(lang);
@@ -46,6 +46,7 @@ extern void ctagsParse(unsigned char *buffer, size_t bufferSize,
 	void *userData);
 extern const char *ctagsGetLangName(int lang);
 extern int ctagsGetNamedLang(const char *name);
+extern int ctagsGetFileLang(const char *fileName);
 extern const char *ctagsGetLangKinds(int lang);
 extern const char *ctagsGetKindName(char kind, int lang);
 extern char ctagsGetKindFromName(const char *name, int lang);
@@ -18,6 +18,7 @@
 #include "debug.h"
 #include "keyword.h"
 #include "options.h"
+#include "parse.h"
 #include "routines.h"
 
 /*
@@ -26,6 +27,7 @@
 typedef struct sHashEntry {
 	struct sHashEntry *next;
 	const char *string;
+	unsigned int hash;
 	langType language;
 	int value;
 } hashEntry;
@@ -33,18 +35,22 @@ typedef struct sHashEntry {
 /*
 *   DATA DEFINITIONS
 */
-static const unsigned int TableSize = 2039;  /* prime */
+static const unsigned int TableSize = 2048;  /* must be a power of two */
 static hashEntry **HashTable = NULL;
 
+/* Languages whose static keywordTable has already been put into HashTable.
+ * Tables are installed on first lookup instead of at parser initialization
+ * so that startup doesn't pay for languages which are never parsed. */
+static bool *InstalledTables = NULL;
+static unsigned int InstalledTablesCount = 0;
+
 /*
 *   FUNCTION DEFINITIONS
 */
 
 static hashEntry **getHashTable (void)
 {
-	static bool allocated = false;
-
-	if (! allocated)
+	if (HashTable == NULL)
 	{
 		unsigned int i;
 
@@ -52,8 +58,6 @@ static hashEntry **getHashTable (void)
 
 		for (i = 0  ;  i < TableSize  ;  ++i)
 			HashTable [i] = NULL;
-
-		allocated = true;
 	}
 	return HashTable;
 }
@@ -63,8 +67,7 @@ static hashEntry *getHashTableEntry (unsigned long hashedValue)
 	hashEntry **const table = getHashTable ();
 	hashEntry *entry;
 
-	Assert (hashedValue < TableSize);
-	entry = table [hashedValue];
+	entry = table [hashedValue & (TableSize - 1)];
 
 	return entry;
 }
@@ -86,13 +89,14 @@ static unsigned int hashValue (const char *const string, langType language)
 	return h;
 }
 
-static hashEntry *newEntry (
-		const char *const string, langType language, int value)
+static hashEntry *newEntry (const char *const string, unsigned int hash,
+		langType language, int value)
 {
 	hashEntry *const entry = xMalloc (1, hashEntry);
 
 	entry->next     = NULL;
 	entry->string   = string;
+	entry->hash     = hash;
 	entry->language = language;
 	entry->value    = value;
 
@@ -106,13 +110,13 @@ static hashEntry *newEntry (
  */
 extern void addKeyword (const char *const string, langType language, int value)
 {
-	const unsigned int index = hashValue (string, language) % TableSize;
-	hashEntry *entry = getHashTableEntry (index);
+	const unsigned int hash = hashValue (string, language);
+	hashEntry *entry = getHashTableEntry (hash);
 
 	if (entry == NULL)
 	{
 		hashEntry **const table = getHashTable ();
-		table [index] = newEntry (string, language, value);
+		table [hash & (TableSize - 1)] = newEntry (string, hash, language, value);
 	}
 	else
 	{
@@ -131,20 +135,50 @@ extern void addKeyword (const char *const string, langType language, int value)
 		if (entry == NULL)
 		{
 			Assert (prev != NULL);
-			prev->next = newEntry (string, language, value);
+			prev->next = newEntry (string, hash, language, value);
 		}
 	}
 }
 
+static void installKeywordTable (const langType language)
+{
+	const parserDefinition *const def = getParserDefinition (language);
+	unsigned int i;
+
+	/* languages can still be defined at runtime with --langdef */
+	if ((unsigned int) language >= InstalledTablesCount)
+	{
+		const unsigned int count = countParsers ();
+
+		InstalledTables = xRealloc (InstalledTables, count, bool);
+		memset (InstalledTables + InstalledTablesCount, 0,
+		        (count - InstalledTablesCount) * sizeof (bool));
+		InstalledTablesCount = count;
+	}
+
+	InstalledTables [language] = true;
+
+	for (i = 0; i < def->keywordCount; ++i)
+		addKeyword (def->keywordTable [i].name, language,
+		            def->keywordTable [i].id);
+}
+
 static int lookupKeywordFull (const char *const string, bool caseSensitive, langType language)
 {
-	const unsigned int index = hashValue (string, language) % TableSize;
-	hashEntry *entry = getHashTableEntry (index);
+	const unsigned int hash = hashValue (string, language);
+	hashEntry *entry;
 	int result = KEYWORD_NONE;
 
+	if (language >= 0 && ((unsigned int) language >= InstalledTablesCount ||
+	                      ! InstalledTables [language]))
+		installKeywordTable (language);
+
+	entry = getHashTableEntry (hash);
 	while (entry != NULL)
 	{
-		if (language == entry->language &&
+		/* comparing the full hash first rejects almost all of the other
+		 * entries in the bucket without touching their strings */
+		if (hash == entry->hash && language == entry->language &&
 			((caseSensitive && strcmp (string, entry->string) == 0) ||
 			 (!caseSensitive && strcasecmp (string, entry->string) == 0)))
 		{
@@ -184,6 +218,13 @@ extern void freeKeywordTable (void)
 			}
 		}
 		eFree (HashTable);
+		HashTable = NULL;
+	}
+	if (InstalledTables != NULL)
+	{
+		eFree (InstalledTables);
+		InstalledTables = NULL;
+		InstalledTablesCount = 0;
 	}
 }
 
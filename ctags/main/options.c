@@ -33,6 +33,7 @@
 #include "output.h"
 #include "parse.h"
 #include "ptag.h"
+#include "ptrarray.h"
 #include "routines.h"
 #include "xtag.h"
 #include "routines.h"
@@ -2154,66 +2155,150 @@ extern const ignoredTokenInfo * isIgnoreToken(const char * name)
 #endif
 
 /* GEANY DIFF */
+/* c_tags_ignore is looked up for every identifier the C-like parsers read, so
+ * it is indexed into a hash table of exact names plus a (usually short) list
+ * of "prefix*" wildcards on first use. Entries remember their position in
+ * c_tags_ignore because, like before, the first matching entry wins. */
+typedef struct sIgnoreEntry {
+	unsigned int position;       /* index in c_tags_ignore */
+	bool ignore;                 /* FOO or FOO+ */
+	bool ignoreParens;           /* FOO+ */
+	const char *replacement;     /* FOO=BAR, points into c_tags_ignore */
+	const char *prefix;          /* FOO*, points into c_tags_ignore */
+	size_t prefixLength;
+} ignoreEntry;
+
+static hashTable *IgnoreNames = NULL;
+static ptrArray *IgnorePrefixes = NULL;
+
+static ignoreEntry *newIgnoreEntry (unsigned int position)
+{
+	ignoreEntry *const entry = xCalloc (1, ignoreEntry);
+
+	entry->position = position;
+	return entry;
+}
+
+static void addIgnoreName (const char *const name, size_t length, ignoreEntry *entry)
+{
+	char *const key = eStrndup (name, length);
+
+	/* an earlier entry for the same name takes precedence */
+	if (hashTableHasItem (IgnoreNames, key))
+	{
+		eFree (key);
+		eFree (entry);
+	}
+	else
+		hashTablePutItem (IgnoreNames, key, entry);
+}
+
+static void buildIgnoreTokens (void)
+{
+	unsigned int i;
+
+	IgnoreNames = hashTableNew (1024, hashCstrhash, hashCstreq, eFree, eFree);
+	IgnorePrefixes = ptrArrayNew (eFree);
+
+	for (i = 0; c_tags_ignore[i] != NULL; i++)
+	{
+		const char *const token = c_tags_ignore[i];
+		const size_t tokenLen = strlen (token);
+		const char *const equals = strchr (token, '=');
+		ignoreEntry *entry;
+
+		if (tokenLen == 0)
+			continue;
+
+		if (tokenLen >= 2 && token[tokenLen - 1] == '*')
+		{
+			entry = newIgnoreEntry (i);
+			entry->ignore = true;
+			entry->prefix = token;
+			entry->prefixLength = tokenLen - 1;
+			ptrArrayAdd (IgnorePrefixes, entry);
+		}
+
+		entry = newIgnoreEntry (i);
+		if (equals != NULL)
+		{
+			entry->replacement = equals + 1;
+			addIgnoreName (token, (size_t) (equals - token), entry);
+		}
+		else if (token[tokenLen - 1] == '+')
+		{
+			entry->ignore = true;
+			entry->ignoreParens = true;
+			addIgnoreName (token, tokenLen - 1, entry);
+		}
+		else
+		{
+			entry->ignore = true;
+			addIgnoreName (token, tokenLen, entry);
+		}
+	}
+}
+
+/* Must be called whenever c_tags_ignore is changed or freed. */
+extern void resetIgnoreTokens (void)
+{
+	if (IgnoreNames != NULL)
+	{
+		hashTableDelete (IgnoreNames);
+		IgnoreNames = NULL;
+	}
+	if (IgnorePrefixes != NULL)
+	{
+		ptrArrayDelete (IgnorePrefixes);
+		IgnorePrefixes = NULL;
+	}
+}
+
 /*  Determines whether or not "name" should be ignored, per the ignore list.
  */
 extern bool isIgnoreToken (const char *const name,
 							  bool *const pIgnoreParens,
 							  const char **const replacement)
 {
-	bool result = false;
+	const ignoreEntry *match;
+	unsigned int i;
 
-	if (c_tags_ignore != NULL)
-	{
-		const size_t nameLen = strlen (name);
-		unsigned int i;
-		unsigned int len = 0;
-		vString *token = vStringNew();
+	if (pIgnoreParens != NULL)
+		*pIgnoreParens = false;
+
+	if (c_tags_ignore == NULL)
+		return false;
 
-		while (c_tags_ignore[len])
-			len++;
+	if (IgnoreNames == NULL)
+		buildIgnoreTokens ();
 
-		if (pIgnoreParens != NULL)
-			*pIgnoreParens = false;
+	match = hashTableGetItem (IgnoreNames, name);
+	for (i = 0; i < ptrArrayCount (IgnorePrefixes); i++)
+	{
+		const ignoreEntry *const entry = ptrArrayItem (IgnorePrefixes, i);
 
-		for (i = 0  ;  i < len ;  ++i)
+		if (match != NULL && match->position < entry->position)
+			break;
+		if (strncmp (entry->prefix, name, entry->prefixLength) == 0)
 		{
-			size_t tokenLen;
+			match = entry;
+			break;
+		}
+	}
 
-			vStringCopyS (token, c_tags_ignore[i]);
-			tokenLen = vStringLength (token);
+	if (match == NULL)
+		return false;
 
-			if (tokenLen >= 2 && vStringChar (token, tokenLen - 1) == '*' &&
-				strncmp (vStringValue (token), name, tokenLen - 1) == 0)
-			{
-				result = true;
-				break;
-			}
-			if (strncmp (vStringValue (token), name, nameLen) == 0)
-			{
-				if (nameLen == tokenLen)
-				{
-					result = true;
-					break;
-				}
-				else if (tokenLen == nameLen + 1  &&
-						vStringChar (token, tokenLen - 1) == '+')
-				{
-					result = true;
-					if (pIgnoreParens != NULL)
-						*pIgnoreParens = true;
-					break;
-				}
-				else if (vStringChar (token, nameLen) == '=')
-				{
-					if (replacement != NULL)
-						*replacement = vStringValue (token) + nameLen + 1;
-					break;
-				}
-			}
-		}
-		vStringDelete (token);
+	if (match->replacement != NULL)
+	{
+		if (replacement != NULL)
+			*replacement = match->replacement;
+		return false;
 	}
-	return result;
+
+	if (pIgnoreParens != NULL)
+		*pIgnoreParens = match->ignoreParens;
+	return match->ignore;
 }
 /* GEANY DIFF END */
 
@@ -160,6 +160,7 @@ extern bool isIncludeFile (const char *const fileName);
 /* GEANY DIFF */
 /* extern const ignoredTokenInfo * isIgnoreToken (const char *const name); */
 extern bool isIgnoreToken (const char *const name, bool *const pIgnoreParens, const char **const replacement);
+extern void resetIgnoreTokens (void);
 /* GEANY DIFF END */
 extern void parseCmdlineOptions (cookedArgs* const cargs);
 extern void previewFirstOption (cookedArgs* const cargs);
@@ -18,8 +18,10 @@
 #include "debug.h"
 #include "entry.h"
 #include "flags.h"
+#include "htable.h"
 #include "keyword.h"
 #include "main.h"
+#include "numarray.h"
 #define OPTION_WRITE
 #include "options.h"
 #include "parsers.h"
@@ -63,7 +65,6 @@ static ptrArray *parsersUsedInCurrentInput;
 #ifndef CTAGS_LIB
 static void addParserPseudoTags (langType language);
 #endif
-static void installKeywordTable (const langType language);
 static void installTagRegexTable (const langType language);
 static void installTagXpathTable (const langType language);
 static void anonResetMaybe (parserDefinition *lang);
@@ -109,6 +110,12 @@ extern unsigned int countParsers (void)
 	return LanguageCount;
 }
 
+extern const parserDefinition *getParserDefinition (langType language)
+{
+	Assert (0 <= language  &&  language < (int) LanguageCount);
+	return LanguageTable[language];
+}
+
 extern int makeSimpleTag (
 		const vString* const name, const int kindIndex)
 {
@@ -272,6 +279,57 @@ extern langType getNamedLanguage (const char *const name, size_t len)
 	return result;
 }
 
+/* Maps each file extension to the languages using it, in ascending order, so
+ * that finding the language of a file doesn't walk the extension lists of all
+ * the parsers. Built on first use and dropped whenever an extension map
+ * changes; the keys point into the parsers' currentExtensions. */
+static hashTable *ExtensionMap = NULL;
+
+static void invalidateExtensionMap (void)
+{
+	if (ExtensionMap != NULL)
+	{
+		hashTableDelete (ExtensionMap);
+		ExtensionMap = NULL;
+	}
+}
+
+static hashTable *getExtensionMap (void)
+{
+	unsigned int i, j;
+
+	if (ExtensionMap != NULL)
+		return ExtensionMap;
+
+#ifdef CASE_INSENSITIVE_FILENAMES
+	ExtensionMap = hashTableNew (509, hashCstrcasehash, hashCstrcaseeq,
+				     NULL, (hashTableFreeFunc) intArrayDelete);
+#else
+	ExtensionMap = hashTableNew (509, hashCstrhash, hashCstreq,
+				     NULL, (hashTableFreeFunc) intArrayDelete);
+#endif
+
+	for (i = 0  ;  i < LanguageCount  ;  ++i)
+	{
+		stringList* const exts = LanguageTable [i]->currentExtensions;
+
+		for (j = 0  ;  exts != NULL  &&  j < stringListCount (exts)  ;  ++j)
+		{
+			char *const extension = vStringValue (stringListItem (exts, j));
+			intArray *langs = hashTableGetItem (ExtensionMap, extension);
+
+			if (langs == NULL)
+			{
+				langs = intArrayNew ();
+				hashTablePutItem (ExtensionMap, extension, langs);
+			}
+			if (intArrayCount (langs) == 0 || intArrayLast (langs) != (int) i)
+				intArrayAdd (langs, i);
+		}
+	}
+	return ExtensionMap;
+}
+
 static langType getNameOrAliasesLanguageAndSpec (const char *const key, langType start_index,
 						 const char **const spec, enum specType *specType)
 {
@@ -344,21 +402,25 @@ static langType getPatternLanguageAndSpec (const char *const baseName, langType
 		}
 	}
 
-	for (i = start_index  ;  i < LanguageCount  &&  result == LANG_IGNORE  ;  ++i)
 	{
-		stringList* const exts = LanguageTable [i]->currentExtensions;
-		vString* tmp;
-
-		/* isLanguageEnabled is not used here.
-		   It calls initializeParser which takes
-		   cost. */
-		if (! LanguageTable [i]->enabled)
-			continue;
+		const char *const extension = fileExtension (baseName);
+		intArray *const langs = hashTableGetItem (getExtensionMap (), extension);
 
-		if (exts != NULL && (tmp = stringListExtensionFinds (exts,
-								     fileExtension (baseName))))
+		for (i = 0  ;  langs != NULL  &&  i < intArrayCount (langs)  ;  ++i)
 		{
-			result = i;
+			const langType lang = intArrayItem (langs, i);
+			vString* tmp;
+
+			/* isLanguageEnabled is not used here.
+			   It calls initializeParser which takes
+			   cost. */
+			if (lang < start_index || ! LanguageTable [lang]->enabled)
+				continue;
+
+			tmp = stringListExtensionFinds (LanguageTable [lang]->currentExtensions,
+							extension);
+			Assert (tmp != NULL);
+			result = lang;
 			*spec = vStringValue(tmp);
 			*specType = SPEC_EXTENSION;
 			goto found;
@@ -1223,6 +1285,7 @@ extern void installLanguageMapDefault (const langType language)
 	parserDefinition* lang;
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	lang = LanguageTable [language];
+	invalidateExtensionMap ();
 	if (lang->currentPatterns != NULL)
 		stringListDelete (lang->currentPatterns);
 	if (lang->currentExtensions != NULL)
@@ -1294,6 +1357,7 @@ extern void installLanguageAliasesDefaults (void)
 extern void clearLanguageMap (const langType language)
 {
 	Assert (0 <= language  &&  language < (int) LanguageCount);
+	invalidateExtensionMap ();
 	stringListClear (LanguageTable [language]->currentPatterns);
 	stringListClear (LanguageTable [language]->currentExtensions);
 }
@@ -1351,6 +1415,7 @@ static bool removeLanguageExtensionMap1 (const langType language, const char *co
 
 	if (exts != NULL  &&  stringListDeleteItemExtension (exts, extension))
 	{
+		invalidateExtensionMap ();
 		verbose (" (removed from %s)", getLanguageName (language));
 		result = true;
 	}
@@ -1380,6 +1445,7 @@ extern void addLanguageExtensionMap (
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 	if (exclusiveInAllLanguages)
 		removeLanguageExtensionMap (LANG_AUTO, extension);
+	invalidateExtensionMap ();
 	stringListAdd (LanguageTable [language]->currentExtensions, str);
 }
 
@@ -1447,7 +1513,6 @@ static void initializeParserOne (langType lang)
 	verbose ("Initialize parser: %s\n", parser->name);
 	parser->initialized = true;
 
-	installKeywordTable (lang);
 	installTagRegexTable (lang);
 	installTagXpathTable (lang);
 	installFieldDefinition     (lang);
@@ -1539,6 +1604,8 @@ extern void initializeParsing (void)
 extern void freeParserResources (void)
 {
 	unsigned int i;
+
+	invalidateExtensionMap ();
 	for (i = 0  ;  i < LanguageCount  ;  ++i)
 	{
 		parserDefinition* const lang = LanguageTable [i];
@@ -2326,12 +2393,6 @@ extern void createTagsWithFallback(unsigned char *buffer, size_t bufferSize,
 		error (WARNING, "Unable to open %s", fileName);
 }
 
-extern const parserDefinition *getParserDefinition (langType language)
-{
-	Assert (0 <= language  &&  language < (int) LanguageCount);
-	return LanguageTable[language];
-}
-
 #endif
 
 #ifdef HAVE_COPROC
@@ -2579,23 +2640,6 @@ static void installTagRegexTable (const langType language)
 	}
 }
 
-static void installKeywordTable (const langType language)
-{
-	parserDefinition* lang;
-	unsigned int i;
-
-	Assert (0 <= language  &&  language < (int) LanguageCount);
-	lang = LanguageTable [language];
-
-	if (lang->keywordTable != NULL)
-	{
-		for (i = 0; i < lang->keywordCount; ++i)
-			addKeyword (lang->keywordTable [i].name,
-				    language,
-				    lang->keywordTable [i].id);
-	}
-}
-
 static void installTagXpathTable (const langType language)
 {
 	parserDefinition* lang;
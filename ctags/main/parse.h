@@ -243,6 +243,7 @@ extern void enableLanguage (const langType language, const bool state);
 extern void initializeParsing (void);
 extern void initializeParser (langType language);
 extern unsigned int countParsers (void);
+extern const parserDefinition *getParserDefinition (langType language);
 extern void freeParserResources (void);
 extern void printLanguageFileKind (const langType language);
 extern void printLanguageKinds (const langType language, bool allKindFields);
@@ -260,7 +261,6 @@ extern void createTagsWithFallback(unsigned char *buffer, size_t bufferSize,
 	const char *fileName, const langType language,
 	tagEntryFunction tagCallback, passStartCallback passCallback,
 	void *userData);
-extern const parserDefinition *getParserDefinition (langType language);
 #endif
 
 #ifdef HAVE_ICONV
@@ -14,6 +14,7 @@
 #include <map>
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include <sstream>
 
 #include <glib.h>
@@ -69,11 +70,39 @@ GtkWidget *PWidget(WindowID wid) noexcept {
 
 enum encodingType { singleByte, UTF8, dbcs };
 
+// What glyph metrics depend on apart from the font: Pango hints them for the resolution,
+// the transformation and the font options it takes from the surface then from the context.
+struct MetricsKey {
+	double resolution = 0;
+	double xx = 1;
+	double xy = 0;
+	double yx = 0;
+	double yy = 1;
+	unsigned long options = 0;
+	bool operator==(const MetricsKey &other) const noexcept {
+		return (resolution == other.resolution) && (xx == other.xx) && (xy == other.xy) &&
+			(yx == other.yx) && (yy == other.yy) && (options == other.options);
+	}
+	// Only has to tell keys apart for the position cache
+	unsigned long long Hash() const noexcept {
+		unsigned long long hash = std::llround(resolution * 1000.0);
+		for (const double coefficient : { xx, xy, yx, yy }) {
+			hash = (hash * 1000003) ^ std::llround(coefficient * 65536.0);
+		}
+		return (hash * 1000003) ^ options;
+	}
+};
+
 // Holds a PangoFontDescription*.
 class FontHandle {
 public:
 	PangoFontDescription *pfd;
 	int characterSet;
+	// Fixed pitch fonts give every printable ASCII character the same advance so runs of
+	// them can be measured without shaping. Found for the metrics of each context measured
+	// in, as painting and laying out usually differ, and guarded as wrapping threads share fonts.
+	std::mutex mutexASCII;
+	std::vector<std::pair<MetricsKey, int>> advancesASCII;
 	FontHandle() noexcept : pfd(nullptr), characterSet(-1) {
 	}
 	FontHandle(PangoFontDescription *pfd_, int characterSet_) noexcept {
@@ -109,6 +138,15 @@ FontHandle *PFont(const Font &f) noexcept {
 	return static_cast<FontHandle *>(f.GetID());
 }
 
+bool IsPrintableASCII(const char *s, int len) noexcept {
+	for (int i = 0; i < len; i++) {
+		if ((s[i] < ' ') || (s[i] > '~')) {
+			return false;
+		}
+	}
+	return true;
+}
+
 }
 
 Font::Font() noexcept : fid(nullptr) {}
@@ -142,7 +180,11 @@ class SurfaceImpl : public Surface {
 	PangoLayout *layout;
 	Converter conv;
 	int characterSet;
+	bool metricsFound;
+	MetricsKey metrics;
 	void SetConverter(int characterSet_);
+	const MetricsKey &Metrics();
+	int AdvanceASCII(FontHandle *pfh);
 public:
 	SurfaceImpl() noexcept;
 	~SurfaceImpl() override;
@@ -188,6 +230,9 @@ public:
 
 	void SetUnicodeMode(bool unicodeMode_) override;
 	void SetDBCSMode(int codePage) override;
+
+	Surface *AllocateForThread() override;
+	unsigned long long MeasurementTag() override;
 };
 }
 
@@ -253,7 +298,7 @@ SurfaceImpl::SurfaceImpl() noexcept : et(singleByte),
 context(nullptr),
 psurf(nullptr),
 x(0), y(0), inited(false), createdGC(false),
-pcontext(nullptr), layout(nullptr), characterSet(-1) {
+pcontext(nullptr), layout(nullptr), characterSet(-1), metricsFound(false) {
 }
 
 SurfaceImpl::~SurfaceImpl() {
@@ -278,6 +323,7 @@ void SurfaceImpl::Clear() noexcept {
 	pcontext = nullptr;
 	conv.Close();
 	characterSet = -1;
+	metricsFound = false;
 	x = 0;
 	y = 0;
 	inited = false;
@@ -766,11 +812,93 @@ public:
 	}
 };
 
+// What the widths measured with this surface depend on apart from the font, found once as
+// the context does not change until the surface is initialised again.
+const MetricsKey &SurfaceImpl::Metrics() {
+	if (!metricsFound) {
+		metrics = MetricsKey();
+		metrics.resolution = pango_cairo_context_get_resolution(pcontext);
+		const PangoMatrix *matrix = pango_context_get_matrix(pcontext);
+		if (matrix) {
+			metrics.xx = matrix->xx;
+			metrics.xy = matrix->xy;
+			metrics.yx = matrix->yx;
+			metrics.yy = matrix->yy;
+		}
+		// Merged like Pango does, the options set on the context overriding the surface's
+		cairo_font_options_t *options = cairo_font_options_create();
+		if (context)
+			cairo_surface_get_font_options(cairo_get_target(context), options);
+		const cairo_font_options_t *optionsContext = pango_cairo_context_get_font_options(pcontext);
+		if (optionsContext)
+			cairo_font_options_merge(options, optionsContext);
+		metrics.options = cairo_font_options_hash(options);
+		cairo_font_options_destroy(options);
+		metricsFound = true;
+	}
+	return metrics;
+}
+
+// The advance of every printable ASCII character in Pango units when the font of the layout
+// is fixed pitch, else 0.
+int SurfaceImpl::AdvanceASCII(FontHandle *pfh) {
+	const MetricsKey &key = Metrics();
+	std::lock_guard<std::mutex> guard(pfh->mutexASCII);
+	for (const std::pair<MetricsKey, int> &advanceMetrics : pfh->advancesASCII) {
+		if (advanceMetrics.first == key) {
+			return advanceMetrics.second;
+		}
+	}
+	// Lay out all the printable characters as one run so any kerning between them shows
+	char printable['~' - ' ' + 1];
+	for (size_t i = 0; i < sizeof(printable); i++) {
+		printable[i] = static_cast<char>(' ' + i);
+	}
+	pango_layout_set_text(layout, printable, sizeof(printable));
+	PangoLayoutIter *iter = pango_layout_get_iter(layout);
+	int advance = -1;
+	int clusters = 0;
+	do {
+		PangoRectangle pos;
+		pango_layout_iter_get_cluster_extents(iter, nullptr, &pos);
+		if (advance < 0) {
+			advance = pos.width;
+		}
+		if ((pos.width != advance) || (pos.x != clusters * advance) ||
+			(pango_layout_iter_get_index(iter) != clusters)) {
+			advance = 0;
+		}
+		clusters++;
+	} while ((advance > 0) && pango_layout_iter_next_cluster(iter));
+	pango_layout_iter_free(iter);
+	if (clusters != static_cast<int>(sizeof(printable))) {
+		advance = 0;
+	}
+	// Only a few contexts are expected so forget the oldest if there are more
+	const size_t advancesMax = 8;
+	if (pfh->advancesASCII.size() >= advancesMax) {
+		pfh->advancesASCII.erase(pfh->advancesASCII.begin());
+	}
+	pfh->advancesASCII.push_back(std::make_pair(key, advance));
+	return advance;
+}
+
 void SurfaceImpl::MeasureWidths(Font &font_, const char *s, int len, XYPOSITION *positions) {
 	if (font_.GetID()) {
 		const int lenPositions = len;
 		if (PFont(font_)->pfd) {
 			pango_layout_set_font_description(layout, PFont(font_)->pfd);
+			if ((et == UTF8) && IsPrintableASCII(s, len)) {
+				// Each character of a fixed pitch font advances by the same amount
+				const int advance = AdvanceASCII(PFont(font_));
+				if (advance > 0) {
+					const XYPOSITION width = floatFromPangoUnits(advance);
+					for (int i = 0; i < len; i++) {
+						positions[i] = width * (i + 1);
+					}
+					return;
+				}
+			}
 			if (et == UTF8) {
 				// Simple and direct as UTF-8 is native Pango encoding
 				int i = 0;
@@ -877,6 +1005,12 @@ XYPOSITION SurfaceImpl::WidthText(Font &font_, const char *s, int len) {
 		if (PFont(font_)->pfd) {
 			std::string utfForm;
 			pango_layout_set_font_description(layout, PFont(font_)->pfd);
+			if ((et == UTF8) && IsPrintableASCII(s, len)) {
+				const int advance = AdvanceASCII(PFont(font_));
+				if (advance > 0) {
+					return floatFromPangoUnits(advance) * len;
+				}
+			}
 			PangoRectangle pos;
 			if (et == UTF8) {
 				pango_layout_set_text(layout, s, len);
@@ -961,6 +1095,33 @@ void SurfaceImpl::SetDBCSMode(int codePage) {
 		et = dbcs;
 }
 
+Surface *SurfaceImpl::AllocateForThread() {
+	if (!pcontext)
+		return nullptr;
+	// Pango objects must not be used by several threads at once, so the new surface gets
+	// its own font map and a context set up like this one to measure the same widths.
+	std::unique_ptr<SurfaceImpl> surface(new SurfaceImpl());
+	PangoFontMap *fontMap = pango_cairo_font_map_new();
+	surface->pcontext = pango_font_map_create_context(fontMap);
+	g_object_unref(fontMap);
+	pango_cairo_context_set_resolution(surface->pcontext, pango_cairo_context_get_resolution(pcontext));
+	pango_cairo_context_set_font_options(surface->pcontext, pango_cairo_context_get_font_options(pcontext));
+	pango_context_set_language(surface->pcontext, pango_context_get_language(pcontext));
+	pango_context_set_base_dir(surface->pcontext, pango_context_get_base_dir(pcontext));
+	pango_context_set_matrix(surface->pcontext, pango_context_get_matrix(pcontext));
+	surface->layout = pango_layout_new(surface->pcontext);
+	surface->et = et;
+	surface->inited = true;
+	return surface.release();
+}
+
+unsigned long long SurfaceImpl::MeasurementTag() {
+	if (!pcontext)
+		return 0;
+	// The same metrics as for the ASCII advances so both treat surfaces alike
+	return Metrics().Hash();
+}
+
 Surface *Surface::Allocate(int) {
 	return new SurfaceImpl();
 }
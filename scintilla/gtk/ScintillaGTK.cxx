@@ -18,6 +18,7 @@
 #include <map>
 #include <algorithm>
 #include <memory>
+#include <mutex>
 
 #include <glib.h>
 #include <gmodule.h>
@@ -1009,7 +1010,7 @@ void ScintillaGTK::ScrollText(Sci::Line linesToMove) {
 	NotifyUpdateUI();
 
 #if GTK_CHECK_VERSION(3,22,0)
-	Redraw();
+	Repaint();
 #else
 	GtkWidget *wi = PWidget(wText);
 	if (IS_WIDGET_REALIZED(wi)) {
@@ -3174,6 +3175,74 @@ void scintilla_release_resources(void) {
 	}
 }
 
+/* C access to the ILoader returned by SCI_CREATELOADER */
+int scintilla_loader_add_data(void *loader, const char *data, gintptr length) {
+	return static_cast<ILoader *>(loader)->AddData(data, length);
+}
+
+void *scintilla_loader_convert_to_document(void *loader) {
+	return static_cast<ILoader *>(loader)->ConvertToDocument();
+}
+
+int scintilla_loader_release(void *loader) {
+	return static_cast<ILoader *>(loader)->Release();
+}
+
+/* Creates a document showing length bytes of text, e.g. a memory mapped file, without
+ * copying them until it is modified. text must stay valid and unchanged until
+ * release(release_data) is called. The document is used like one from
+ * SCI_CREATEDOCUMENT, so options are SC_DOCUMENTOPTION_* values.
+ * Returns NULL on failure, after calling release. */
+void *scintilla_document_new_external(const char *text, gintptr length, int options,
+	void (*release)(void *), void *release_data) {
+	Document *doc;
+	try {
+		doc = new Document(options);
+	} catch (...) {
+		if (release)
+			release(release_data);
+		return nullptr;
+	}
+	doc->AddRef();
+	try {
+		doc->SetExternalText(text, length, release, release_data);
+	} catch (...) {
+		// Releases the text as well
+		doc->Release();
+		return nullptr;
+	}
+	return doc;
+}
+
+/* Creates a document with the text of document, as got from SCI_GETDOCPOINTER, without
+ * copying it. Both documents share the text until either is modified, when the modified
+ * one copies it. Styles, undo history and other settings apart from the undo memory limit
+ * are not copied. The document is used like one from SCI_CREATEDOCUMENT.
+ * Returns NULL on failure. */
+void *scintilla_document_clone(void *document) {
+	Document *source = static_cast<Document *>(document);
+	Document *doc;
+	try {
+		doc = new Document(source->Options());
+	} catch (...) {
+		return nullptr;
+	}
+	doc->AddRef();
+	try {
+		source->ShareText(*doc);
+	} catch (...) {
+		doc->Release();
+		return nullptr;
+	}
+	return doc;
+}
+
+/* Returns whether document, as got from SCI_GETDOCPOINTER, still shows text it did not copy
+ * from scintilla_document_new_external(), directly or through scintilla_document_clone(). */
+int scintilla_document_is_external(void *document) {
+	return static_cast<Document *>(document)->HasExternalText();
+}
+
 /* Define a dummy boxed type because g-ir-scanner is unable to
  * recognize gpointer-derived types. Note that SCNotificaiton
  * is always allocated on stack so copying is not appropriate. */
@@ -62,6 +62,7 @@
 #include <map>
 #include <algorithm>
 #include <memory>
+#include <mutex>
 
 #include <glib.h>
 #include <gtk/gtk.h>
@@ -838,11 +839,14 @@ void ScintillaGTKAccessible::ChangeDocument(Document *oldDoc, Document *newDoc)
 	if (oldDoc) {
 		int charLength = oldDoc->CountCharacters(0, oldDoc->Length());
 		g_signal_emit_by_name(accessible, "text-changed::delete", 0, charLength);
+		// The character index belongs to the document being shown
+		oldDoc->ReleaseLineCharacterIndex(SC_LINECHARACTERINDEX_UTF32);
 	}
 
 	if (newDoc) {
 		PLATFORM_ASSERT(newDoc == sci->pdoc);
 
+		newDoc->AllocateLineCharacterIndex(SC_LINECHARACTERINDEX_UTF32);
 		int charLength = newDoc->CountCharacters(0, newDoc->Length());
 		g_signal_emit_by_name(accessible, "text-changed::insert", 0, charLength);
 
@@ -387,6 +387,14 @@ public:
 
 	virtual void SetUnicodeMode(bool unicodeMode_)=0;
 	virtual void SetDBCSMode(int codePage)=0;
+
+	/// Allocate a surface measuring text like this one that may be used on another thread
+	/// at the same time. Returns nullptr when the platform can not do that.
+	virtual Surface *AllocateForThread() { return nullptr; }
+
+	/// Differs between surfaces that measure the same text in the same font differently,
+	/// such as at another resolution or with other font options.
+	virtual unsigned long long MeasurementTag() { return LogPixelsY(); }
 };
 
 /**
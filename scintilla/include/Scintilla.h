@@ -331,6 +331,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_SETCARETLINEFRAME 2705
 #define SCI_STYLESETCHANGEABLE 2099
 #define SCI_AUTOCSHOW 2100
+#define SCI_AUTOCSHOWITEMS 2734
 #define SCI_AUTOCCANCEL 2101
 #define SCI_AUTOCACTIVE 2102
 #define SCI_AUTOCPOSSTART 2103
@@ -432,6 +433,9 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_CANPASTE 2173
 #define SCI_CANUNDO 2174
 #define SCI_EMPTYUNDOBUFFER 2175
+#define SCI_SETUNDOMEMORYLIMIT 2730
+#define SCI_GETUNDOMEMORYLIMIT 2731
+#define SCI_GETUNDOMEMORY 2732
 #define SCI_UNDO 2176
 #define SCI_CUT 2177
 #define SCI_COPY 2178
@@ -499,6 +503,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SC_FOLDACTION_CONTRACT 0
 #define SC_FOLDACTION_EXPAND 1
 #define SC_FOLDACTION_TOGGLE 2
+#define SC_FOLDACTION_CONTRACT_EVERY_LEVEL 4
 #define SCI_FOLDLINE 2237
 #define SCI_FOLDCHILDREN 2238
 #define SCI_EXPANDCHILDREN 2239
@@ -564,6 +569,8 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SC_CACHE_DOCUMENT 3
 #define SCI_SETLAYOUTCACHE 2272
 #define SCI_GETLAYOUTCACHE 2273
+#define SCI_SETLAYOUTCACHEMEMORY 2728
+#define SCI_GETLAYOUTCACHEMEMORY 2729
 #define SCI_SETSCROLLWIDTH 2274
 #define SCI_GETSCROLLWIDTH 2275
 #define SCI_SETSCROLLWIDTHTRACKING 2516
@@ -846,12 +853,17 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_GETINDICATORVALUE 2503
 #define SCI_INDICATORFILLRANGE 2504
 #define SCI_INDICATORCLEARRANGE 2505
+#define SCI_INDICATORFILLRANGES 2733
 #define SCI_INDICATORALLONFOR 2506
 #define SCI_INDICATORVALUEAT 2507
 #define SCI_INDICATORSTART 2508
 #define SCI_INDICATOREND 2509
 #define SCI_SETPOSITIONCACHE 2514
 #define SCI_GETPOSITIONCACHE 2515
+#define SCI_SETSHAREDPOSITIONCACHE 2724
+#define SCI_GETSHAREDPOSITIONCACHE 2725
+#define SCI_GETPOSITIONCACHEHITS 2726
+#define SCI_GETPOSITIONCACHEMISSES 2727
 #define SCI_COPYALLOWLINE 2519
 #define SCI_GETCHARACTERPOINTER 2520
 #define SCI_GETRANGEPOINTER 2643
@@ -46,6 +46,15 @@ GType		scintilla_object_get_type		(void);
 GtkWidget*	scintilla_object_new			(void);
 gintptr		scintilla_object_send_message	(ScintillaObject *sci, unsigned int iMessage, guintptr wParam, gintptr lParam);
 
+/* the ILoader interface of SCI_CREATELOADER for C code */
+int			scintilla_loader_add_data		(void *loader, const char *data, gintptr length);
+void*		scintilla_loader_convert_to_document	(void *loader);
+int			scintilla_loader_release		(void *loader);
+void*		scintilla_document_new_external	(const char *text, gintptr length, int options,
+											 void (*release)(void *), void *release_data);
+void*		scintilla_document_clone		(void *document);
+int			scintilla_document_is_external	(void *document);
+
 
 GType		scnotification_get_type			(void);
 #define SCINTILLA_TYPE_NOTIFICATION        (scnotification_get_type())
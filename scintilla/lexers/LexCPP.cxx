@@ -13,10 +13,12 @@
 #include <assert.h>
 #include <ctype.h>
 
+#include <cstdint>
 #include <utility>
 #include <string>
 #include <vector>
 #include <map>
+#include <tuple>
 #include <algorithm>
 #include <iterator>
 
@@ -311,6 +313,12 @@ public:
 			ifTaken |= maskLevel();
 		}
 	}
+	bool operator<(const LinePPState &other) const noexcept {
+		return std::tie(state, ifTaken, level) < std::tie(other.state, other.ifTaken, other.level);
+	}
+	bool operator==(const LinePPState &other) const noexcept {
+		return (state == other.state) && (ifTaken == other.ifTaken) && (level == other.level);
+	}
 };
 
 // Hold the preprocessor state for each line seen.
@@ -331,6 +339,229 @@ public:
 	}
 };
 
+// Everything the lexer carries from the end of one line into the next, apart from the
+// preprocessor definitions which only matter to lines that evaluate or change them.
+struct LineStartState {
+	int style = SCE_C_DEFAULT;
+	LinePPState preproc;
+	int activitySet = 0;
+	int chPrevNonWhite = ' ';
+	int styleBeforeDCKeyword = SCE_C_DEFAULT;
+	int styleBeforeTaskMarker = SCE_C_DEFAULT;
+	bool continuationLine = false;
+	bool isStringInPreprocessor = false;
+	bool seenDocKeyBrace = false;
+	bool operator<(const LineStartState &other) const noexcept {
+		return std::tie(style, preproc, activitySet, chPrevNonWhite, styleBeforeDCKeyword,
+			styleBeforeTaskMarker, continuationLine, isStringInPreprocessor, seenDocKeyBrace) <
+			std::tie(other.style, other.preproc, other.activitySet, other.chPrevNonWhite, other.styleBeforeDCKeyword,
+			other.styleBeforeTaskMarker, other.continuationLine, other.isStringInPreprocessor, other.seenDocKeyBrace);
+	}
+	bool operator==(const LineStartState &other) const noexcept {
+		return std::tie(style, preproc, activitySet, chPrevNonWhite, styleBeforeDCKeyword,
+			styleBeforeTaskMarker, continuationLine, isStringInPreprocessor, seenDocKeyBrace) ==
+			std::tie(other.style, other.preproc, other.activitySet, other.chPrevNonWhite, other.styleBeforeDCKeyword,
+			other.styleBeforeTaskMarker, other.continuationLine, other.isStringInPreprocessor, other.seenDocKeyBrace);
+	}
+};
+
+// How a line was last lexed: the states at its start and at the start of the next line,
+// as indices into the table of distinct states, and a hash of its text and styles.
+// A line reached in its entry state whose hash still matches is styled correctly already
+// and leads into its exit state, so it need not be lexed again.
+// Lines that change the preprocessor definitions have no entry state so are always lexed.
+struct LineCheckpoint {
+	int entry;
+	int exit;
+	std::uint64_t hash;
+	LineCheckpoint() noexcept : entry(-1), exit(-1), hash(0) {
+	}
+	LineCheckpoint(int entry_, int exit_, std::uint64_t hash_) noexcept :
+		entry(entry_), exit(exit_), hash(hash_) {
+	}
+};
+
+constexpr std::uint64_t hashOffsetBasis = 14695981039346656037ULL;
+constexpr std::uint64_t hashPrime = 1099511628211ULL;
+
+constexpr std::uint64_t HashValue(std::uint64_t hash, unsigned int value) noexcept {
+	return (hash ^ value) * hashPrime;
+}
+
+std::uint64_t HashString(std::uint64_t hash, const std::string &s) noexcept {
+	for (const char ch : s) {
+		hash = HashValue(hash, static_cast<unsigned char>(ch));
+	}
+	// Terminate so that "ab", "c" hashes differently to "a", "bc"
+	return HashValue(hash, 0x100);
+}
+
+// Hash of the sequence of changes to the preprocessor definitions so that the definitions
+// at two points can be compared cheaply.
+std::uint64_t HashDefinition(std::uint64_t hash, const PPDefinition &ppDef) noexcept {
+	hash = HashString(hash, ppDef.key);
+	hash = HashString(hash, ppDef.value);
+	hash = HashString(hash, ppDef.arguments);
+	return HashValue(hash, ppDef.isUndef);
+}
+
+// Hash bytes a word at a time as this is done for every line lexed. Not using the
+// per-byte HashValue so folding back the high bits keeps each byte affecting the result.
+std::uint64_t HashBytes(std::uint64_t hash, const char *bytes, Sci_Position length) noexcept {
+	Sci_Position i = 0;
+	for (; i + 8 <= length; i += 8) {
+		std::uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * hashPrime;
+		hash ^= hash >> 32;
+	}
+	for (; i < length; i++) {
+		hash = HashValue(hash, static_cast<unsigned char>(bytes[i]));
+	}
+	return hash;
+}
+
+// Hash the text and styles of a line. The output of a line containing '#' may depend on
+// the preprocessor definitions so those are included for such lines.
+std::uint64_t HashLine(const char *text, const char *styles, Sci_Position length,
+	std::uint64_t definitionsHash) noexcept {
+	std::uint64_t hash = HashValue(hashOffsetBasis, static_cast<unsigned int>(length));
+	hash = HashBytes(hash, text, length);
+	hash = HashBytes(hash, styles, length);
+	if (memchr(text, '#', length)) {
+		hash = HashValue(hash, static_cast<unsigned int>(definitionsHash));
+		hash = HashValue(hash, static_cast<unsigned int>(definitionsHash >> 32));
+	}
+	return hash;
+}
+
+// Hash a line as it is in the document now.
+std::uint64_t HashLine(LexAccessor &styler, Sci_Position line, std::uint64_t definitionsHash) {
+	const Sci_Position start = styler.LineStart(line);
+	const Sci_Position length = styler.LineStart(line + 1) - start;
+	std::string text(length, '\0');
+	std::string styles(length, '\0');
+	for (Sci_Position i = 0; i < length; i++) {
+		text[i] = styler[start + i];
+		styles[i] = styler.StyleAt(start + i);
+	}
+	return HashLine(text.c_str(), styles.c_str(), length, definitionsHash);
+}
+
+// Passes every call on to the document while keeping a copy of the styles set from start
+// on, so the lines just lexed can be hashed without reading each style back.
+class StyleRecorder : public IDocumentWithLineEnd {
+	IDocument *pAccess;
+	Sci_Position start;
+	Sci_Position positionStyling;
+	std::string styles;
+	void Record(Sci_Position length, const char *stylesSet, char style) {
+		const Sci_Position offset = positionStyling - start;
+		positionStyling += length;
+		if ((offset < 0) || (length <= 0))
+			return;
+		if (static_cast<size_t>(offset + length) > styles.size())
+			styles.resize(offset + length);
+		if (stylesSet)
+			std::copy(stylesSet, stylesSet + length, styles.begin() + offset);
+		else
+			std::fill(styles.begin() + offset, styles.begin() + offset + length, style);
+	}
+public:
+	StyleRecorder(IDocument *pAccess_, Sci_Position start_) :
+		pAccess(pAccess_), start(start_), positionStyling(start_) {
+	}
+	// Forget the styles before position.
+	void Discard(Sci_Position position) {
+		if (position > start) {
+			styles.erase(0, std::min(static_cast<size_t>(position - start), styles.size()));
+			start = position;
+		}
+	}
+	// The styles recorded for a range or nullptr if not all of it was styled.
+	const char *Styles(Sci_Position position, Sci_Position length) const noexcept {
+		if ((position < start) || (static_cast<size_t>(position - start + length) > styles.size()))
+			return nullptr;
+		return styles.c_str() + (position - start);
+	}
+	int SCI_METHOD Version() const override {
+		return pAccess->Version();
+	}
+	void SCI_METHOD SetErrorStatus(int status) override {
+		pAccess->SetErrorStatus(status);
+	}
+	Sci_Position SCI_METHOD Length() const override {
+		return pAccess->Length();
+	}
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		pAccess->GetCharRange(buffer, position, lengthRetrieve);
+	}
+	char SCI_METHOD StyleAt(Sci_Position position) const override {
+		return pAccess->StyleAt(position);
+	}
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override {
+		return pAccess->LineFromPosition(position);
+	}
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override {
+		return pAccess->LineStart(line);
+	}
+	int SCI_METHOD GetLevel(Sci_Position line) const override {
+		return pAccess->GetLevel(line);
+	}
+	int SCI_METHOD SetLevel(Sci_Position line, int level) override {
+		return pAccess->SetLevel(line, level);
+	}
+	int SCI_METHOD GetLineState(Sci_Position line) const override {
+		return pAccess->GetLineState(line);
+	}
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override {
+		return pAccess->SetLineState(line, state);
+	}
+	void SCI_METHOD StartStyling(Sci_Position position, char mask) override {
+		positionStyling = position;
+		pAccess->StartStyling(position, mask);
+	}
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override {
+		Record(length, nullptr, style);
+		return pAccess->SetStyleFor(length, style);
+	}
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *stylesSet) override {
+		Record(length, stylesSet, 0);
+		return pAccess->SetStyles(length, stylesSet);
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override {
+		pAccess->DecorationSetCurrentIndicator(indicator);
+	}
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override {
+		pAccess->DecorationFillRange(position, value, fillLength);
+	}
+	void SCI_METHOD ChangeLexerState(Sci_Position startChange, Sci_Position endChange) override {
+		pAccess->ChangeLexerState(startChange, endChange);
+	}
+	int SCI_METHOD CodePage() const override {
+		return pAccess->CodePage();
+	}
+	bool SCI_METHOD IsDBCSLeadByte(char ch) const override {
+		return pAccess->IsDBCSLeadByte(ch);
+	}
+	const char * SCI_METHOD BufferPointer() override {
+		return pAccess->BufferPointer();
+	}
+	int SCI_METHOD GetLineIndentation(Sci_Position line) override {
+		return pAccess->GetLineIndentation(line);
+	}
+	// Only called when Version() reports dvLineEnd
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override {
+		return static_cast<IDocumentWithLineEnd *>(pAccess)->LineEnd(line);
+	}
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override {
+		return static_cast<IDocumentWithLineEnd *>(pAccess)->GetRelativePosition(positionStart, characterOffset);
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		return static_cast<IDocumentWithLineEnd *>(pAccess)->GetCharacterAndWidth(position, pWidth);
+	}
+};
+
 // An individual named option for use in an OptionSet
 
 // Options used for LexerCPP
@@ -537,6 +768,14 @@ class LexerCPP : public ILexerWithMetaData {
 	OptionSetCPP osCPP;
 	EscapeSequence escapeSeq;
 	SparseState<std::string> rawStringTerminators;
+	std::vector<LineStartState> lineStartStates;
+	std::map<LineStartState, int> lineStartStateIndex;
+	// The last state found for each of a few classes of state, checked before the map
+	int stateRecent[64];
+	// Checkpoints are indexed by line like vlls and moved when lines are inserted or removed.
+	std::vector<LineCheckpoint> checkpoints;
+	Sci_Position linesCheckpointed = 0;
+	int codePageCheckpoints = 0;
 	enum { ssIdentifier, ssDocKeyword };
 	SubStyles subStyles;
 	std::string returnBuffer;
@@ -550,6 +789,7 @@ public:
 		setRelOp(CharacterSet::setNone, "=!<>"),
 		setLogicalOp(CharacterSet::setNone, "|&"),
 		subStyles(styleSubable, 0x80, 0x40, inactiveFlag) {
+		std::fill(std::begin(stateRecent), std::end(stateRecent), -1);
 	}
 	// Deleted so LexerCPP objects can not be copied.
 	LexerCPP(const LexerCPP &) = delete;
@@ -590,6 +830,7 @@ public:
 	}
 
 	int SCI_METHOD AllocateSubStyles(int styleBase, int numberStyles) override {
+		ClearCheckpoints();
 		return subStyles.Allocate(styleBase, numberStyles);
 	}
 	int SCI_METHOD SubStylesStart(int styleBase) override {
@@ -607,9 +848,11 @@ public:
 		return MaskActive(style);
 	}
 	void SCI_METHOD FreeSubStyles() override {
+		ClearCheckpoints();
 		subStyles.Free();
 	}
 	void SCI_METHOD SetIdentifiers(int style, const char *identifiers) override {
+		ClearCheckpoints();
 		subStyles.SetIdentifiers(style, identifiers);
 	}
 	int SCI_METHOD DistanceToSecondaryStyles() noexcept override {
@@ -684,6 +927,12 @@ public:
 	void EvaluateTokens(std::vector<std::string> &tokens, const SymbolTable &preprocessorDefinitions);
 	std::vector<std::string> Tokenize(const std::string &expr) const;
 	bool EvaluateExpression(const std::string &expr, const SymbolTable &preprocessorDefinitions);
+	int StateIndex(const LineStartState &lss);
+	bool LineUnchanged(LexAccessor &styler, Sci_Position line, int state, std::uint64_t definitionsHash) const;
+	void ShiftCheckpoints(Sci_Position line, Sci_Position shift);
+	void ClearCheckpoints() noexcept;
+	Sci_Position LexLines(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess,
+		SymbolTable &preprocessorDefinitions, std::uint64_t &definitionsHash, int &stateLine, bool &lexerStateChanged);
 };
 
 Sci_Position SCI_METHOD LexerCPP::PropertySet(const char *key, const char *val) {
@@ -694,6 +943,7 @@ Sci_Position SCI_METHOD LexerCPP::PropertySet(const char *key, const char *val)
 				setWord.Add('$');
 			}
 		}
+		ClearCheckpoints();
 		return 0;
 	}
 	return -1;
@@ -728,6 +978,7 @@ Sci_Position SCI_METHOD LexerCPP::WordListSet(int n, const char *wl) {
 		if (*wordListN != wlNew) {
 			wordListN->Set(wl);
 			firstModification = 0;
+			ClearCheckpoints();
 			if (n == 4) {
 				// Rebuild preprocessorDefinitions
 				preprocessorDefinitionsStart.clear();
@@ -759,8 +1010,132 @@ Sci_Position SCI_METHOD LexerCPP::WordListSet(int n, const char *wl) {
 	return firstModification;
 }
 
+int LexerCPP::StateIndex(const LineStartState &lss) {
+	// Lines mostly start in a few states which the style and previous character tell apart
+	int &recent = stateRecent[(lss.style * 31 + lss.chPrevNonWhite) & 0x3f];
+	if ((recent >= 0) && (lss == lineStartStates[recent])) {
+		return recent;
+	}
+	const std::pair<std::map<LineStartState, int>::iterator, bool> inserted =
+		lineStartStateIndex.insert(std::make_pair(lss, static_cast<int>(lineStartStates.size())));
+	if (inserted.second) {
+		lineStartStates.push_back(lss);
+	}
+	recent = inserted.first->second;
+	return recent;
+}
+
+// Whether line is styled correctly already when entered in state.
+bool LexerCPP::LineUnchanged(LexAccessor &styler, Sci_Position line, int state,
+	std::uint64_t definitionsHash) const {
+	if ((line >= static_cast<Sci_Position>(checkpoints.size())) || (checkpoints[line].entry != state)) {
+		return false;
+	}
+	// Raw string terminators are tracked per line so lines in raw strings are always lexed.
+	// The end of a line continued with '\\' is only styled once the next line is lexed.
+	const LineStartState &entry = lineStartStates[state];
+	const LineStartState &exit = lineStartStates[checkpoints[line].exit];
+	if ((MaskActive(entry.style) == SCE_C_STRINGRAW) || (MaskActive(exit.style) == SCE_C_STRINGRAW) ||
+		entry.continuationLine || exit.continuationLine) {
+		return false;
+	}
+	return checkpoints[line].hash == HashLine(styler, line, definitionsHash);
+}
+
+// Lines inserted or removed since the last lex are taken to be at line, where lexing starts,
+// since that is at or before the first change. When there were changes further on, lines
+// up to the last of them are lexed again as their checkpoints do not line up.
+void LexerCPP::ShiftCheckpoints(Sci_Position line, Sci_Position shift) {
+	const Sci_Position size = checkpoints.size();
+	if (line >= size) {
+		return;
+	}
+	if (shift > 0) {
+		checkpoints.insert(checkpoints.begin() + line, shift, LineCheckpoint());
+	} else if (shift < 0) {
+		checkpoints.erase(checkpoints.begin() + line, checkpoints.begin() + std::min(line - shift, size));
+	}
+}
+
+void LexerCPP::ClearCheckpoints() noexcept {
+	checkpoints.clear();
+	lineStartStates.clear();
+	lineStartStateIndex.clear();
+	std::fill(std::begin(stateRecent), std::end(stateRecent), -1);
+}
+
 void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) {
 	LexAccessor styler(pAccess);
+	const Sci_PositionU endPos = startPos + length;
+
+	// States no longer used by any line stay in the table so start again when there are
+	// many more than lines.
+	const Sci_Position lines = styler.GetLine(styler.Length()) + 1;
+	if ((pAccess->CodePage() != codePageCheckpoints) ||
+		(static_cast<Sci_Position>(lineStartStates.size()) > 2 * lines + 1024)) {
+		ClearCheckpoints();
+		codePageCheckpoints = pAccess->CodePage();
+	}
+	ShiftCheckpoints(styler.GetLine(startPos), lines - linesCheckpointed);
+	linesCheckpointed = lines;
+
+	bool lexerStateChanged = false;
+
+	// Truncate ppDefineHistory before current line
+
+	if (!options.updatePreprocessor)
+		ppDefineHistory.clear();
+
+	const Sci_Position lineStart = styler.GetLine(startPos);
+	std::vector<PPDefinition>::iterator itInvalid = std::find_if(ppDefineHistory.begin(), ppDefineHistory.end(),
+		[lineStart](const PPDefinition &p) { return p.line >= lineStart; });
+	if (itInvalid != ppDefineHistory.end()) {
+		ppDefineHistory.erase(itInvalid, ppDefineHistory.end());
+		lexerStateChanged = true;
+	}
+
+	SymbolTable preprocessorDefinitions = preprocessorDefinitionsStart;
+	std::uint64_t definitionsHash = hashOffsetBasis;
+	for (const PPDefinition &ppDef : ppDefineHistory) {
+		if (ppDef.isUndef)
+			preprocessorDefinitions.erase(ppDef.key);
+		else
+			preprocessorDefinitions[ppDef.key] = SymbolValue(ppDef.value, ppDef.arguments);
+		definitionsHash = HashDefinition(definitionsHash, ppDef);
+	}
+
+	// Lex until reaching a line in the state it was last lexed from whose text and styles
+	// are unchanged, then step over such lines and lex again from the first that differs.
+	Sci_PositionU startLines = startPos;
+	int stateLine = -1;
+	for (;;) {
+		Sci_Position line = LexLines(startLines, endPos - startLines, initStyle, pAccess,
+			preprocessorDefinitions, definitionsHash, stateLine, lexerStateChanged);
+		if (line < 0)
+			break;
+		for (;;) {
+			line++;
+			vlls.Add(line, lineStartStates[stateLine].preproc);
+			startLines = styler.LineStart(line);
+			if ((startLines >= endPos) || !LineUnchanged(styler, line, stateLine, definitionsHash))
+				break;
+			stateLine = checkpoints[line].exit;
+		}
+		if (startLines >= endPos) {
+			styler.StartAt(endPos);
+			break;
+		}
+		initStyle = lineStartStates[stateLine].style;
+	}
+
+	if (lexerStateChanged)
+		styler.ChangeLexerState(startPos, startPos + length);
+}
+
+Sci_Position LexerCPP::LexLines(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess,
+	SymbolTable &preprocessorDefinitions, std::uint64_t &definitionsHash, int &stateLine, bool &lexerStateChanged) {
+	StyleRecorder recorder(pAccess, startPos);
+	LexAccessor styler(&recorder);
 
 	CharacterSet setOKBeforeRE(CharacterSet::setNone, "([{=,:;!%^&*|?~+-");
 	CharacterSet setCouldBePostOp(CharacterSet::setNone, "+-");
@@ -812,33 +1187,93 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 	StyleContext sc(startPos, length, initStyle, styler);
 	LinePPState preproc = vlls.ForLine(lineCurrent);
 
-	bool definitionsChanged = false;
-
-	// Truncate ppDefineHistory before current line
-
-	if (!options.updatePreprocessor)
-		ppDefineHistory.clear();
-
-	std::vector<PPDefinition>::iterator itInvalid = std::find_if(ppDefineHistory.begin(), ppDefineHistory.end(),
-		[lineCurrent](const PPDefinition &p) { return p.line >= lineCurrent; });
-	if (itInvalid != ppDefineHistory.end()) {
-		ppDefineHistory.erase(itInvalid, ppDefineHistory.end());
-		definitionsChanged = true;
-	}
-
-	SymbolTable preprocessorDefinitions = preprocessorDefinitionsStart;
-	for (const PPDefinition &ppDef : ppDefineHistory) {
-		if (ppDef.isUndef)
-			preprocessorDefinitions.erase(ppDef.key);
-		else
-			preprocessorDefinitions[ppDef.key] = SymbolValue(ppDef.value, ppDef.arguments);
-	}
-
 	std::string rawStringTerminator = rawStringTerminators.ValueAt(lineCurrent-1);
 	SparseState<std::string> rawSTNew(lineCurrent);
 
 	int activitySet = preproc.ActiveState();
 
+	const bool continuing = stateLine >= 0;
+	if (continuing) {
+		// Continuing after unchanged lines so start from the state they ended in
+		const LineStartState &lss = lineStartStates[stateLine];
+		preproc = lss.preproc;
+		activitySet = lss.activitySet;
+		chPrevNonWhite = lss.chPrevNonWhite;
+		styleBeforeDCKeyword = lss.styleBeforeDCKeyword;
+		styleBeforeTaskMarker = lss.styleBeforeTaskMarker;
+		continuationLine = lss.continuationLine;
+		isStringInPreprocessor = lss.isStringInPreprocessor;
+		seenDocKeyBrace = lss.seenDocKeyBrace;
+		sc.chPrev = styler.SafeGetCharAt(startPos - 1);
+	}
+
+	auto stateAtLineStart = [&]() {
+		LineStartState lss;
+		lss.style = sc.state;
+		lss.preproc = preproc;
+		lss.activitySet = activitySet;
+		lss.chPrevNonWhite = chPrevNonWhite;
+		lss.styleBeforeDCKeyword = styleBeforeDCKeyword;
+		lss.styleBeforeTaskMarker = styleBeforeTaskMarker;
+		lss.continuationLine = continuationLine;
+		lss.isStringInPreprocessor = isStringInPreprocessor;
+		lss.seenDocKeyBrace = seenDocKeyBrace;
+		return StateIndex(lss);
+	};
+
+	// Lines started in this call with their states, definitions and number of
+	// definitions at the start, used to make checkpoints once styled.
+	struct LineLexed {
+		Sci_Position line;
+		Sci_Position start;
+		int state;
+		std::uint64_t definitionsHash;
+		size_t definitions;
+	};
+	std::vector<LineLexed> linesLexed;
+	Sci_Position lineConverged = -1;
+	int stateEnd = -1;
+	const Sci_PositionU lengthDoc = styler.Length();
+
+	// Make checkpoints for the lines lexed that end by styled, the last leading into
+	// stateFinal, then forget them and their styles.
+	std::string text;
+	auto makeCheckpoints = [&](Sci_PositionU styled, int stateFinal) {
+		size_t lines = 0;
+		Sci_Position end = 0;
+		for (; lines < linesLexed.size(); lines++) {
+			const bool last = (lines + 1) == linesLexed.size();
+			const Sci_Position endLine = last ? styler.LineStart(linesLexed[lines].line + 1) : linesLexed[lines + 1].start;
+			if ((last && (stateFinal < 0)) || (static_cast<Sci_PositionU>(endLine) > styled))
+				break;
+			end = endLine;
+		}
+		if (lines == 0)
+			return;
+		const Sci_Position start = linesLexed.front().start;
+		text.resize(end - start);
+		pAccess->GetCharRange(&text[0], start, end - start);
+		const char *styles = recorder.Styles(start, end - start);
+		for (size_t i = 0; i < lines; i++) {
+			const LineLexed &lexed = linesLexed[i];
+			const bool last = (i + 1) == linesLexed.size();
+			const int exit = last ? stateFinal : linesLexed[i + 1].state;
+			const size_t definitionsEnd = last ? ppDefineHistory.size() : linesLexed[i + 1].definitions;
+			const Sci_Position endLine = ((i + 1) < lines) ? linesLexed[i + 1].start : end;
+			const std::uint64_t hash = styles ?
+				HashLine(text.c_str() + (lexed.start - start), styles + (lexed.start - start),
+					endLine - lexed.start, lexed.definitionsHash) :
+				HashLine(styler, lexed.line, lexed.definitionsHash);
+			if (lexed.line >= static_cast<Sci_Position>(checkpoints.size())) {
+				checkpoints.resize(lexed.line + 1);
+			}
+			checkpoints[lexed.line] = LineCheckpoint((definitionsEnd == lexed.definitions) ? lexed.state : -1,
+				exit, hash);
+		}
+		linesLexed.erase(linesLexed.begin(), linesLexed.begin() + lines);
+		recorder.Discard(linesLexed.empty() ? styled : linesLexed.front().start);
+	};
+
 	const WordClassifier &classifierIdentifiers = subStyles.Classifier(SCE_C_IDENTIFIER);
 	const WordClassifier &classifierDocKeyWords = subStyles.Classifier(SCE_C_COMMENTDOCKEYWORD);
 
@@ -846,6 +1281,25 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 
 	for (; sc.More();) {
 
+		// Unless continuing, the first line is lexed without knowing all of the state carried
+		// into it, such as sc.chPrev, so it is always lexed and no checkpoint is made.
+		if (sc.atLineStart && (continuing || (sc.currentPos != startPos))) {
+			stateLine = stateAtLineStart();
+			if ((sc.currentPos < lengthDoc) && LineUnchanged(styler, lineCurrent, stateLine, definitionsHash)) {
+				// Continue after the line in the state it ends in
+				lineConverged = lineCurrent;
+				stateEnd = stateLine;
+				stateLine = checkpoints[lineCurrent].exit;
+				break;
+			}
+			linesLexed.push_back({lineCurrent, static_cast<Sci_Position>(sc.currentPos), stateLine, definitionsHash, ppDefineHistory.size()});
+			// Styles before the segment being lexed are final
+			if (linesLexed.size() >= 1000) {
+				styler.Flush();
+				makeCheckpoints(styler.GetStartSegment(), -1);
+			}
+		}
+
 		if (sc.atLineStart) {
 			// Using MaskActive() is not needed in the following statement.
 			// Inside inactive preprocessor declaration, state will be reset anyway at the end of this block.
@@ -1370,7 +1824,8 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 										value = restOfLine.substr(startValue);
 									preprocessorDefinitions[key] = SymbolValue(value, args);
 									ppDefineHistory.push_back(PPDefinition(lineCurrent, key, value, false, args));
-									definitionsChanged = true;
+									definitionsHash = HashDefinition(definitionsHash, ppDefineHistory.back());
+									lexerStateChanged = true;
 								} else {
 									// Value
 									size_t startValue = endName;
@@ -1381,7 +1836,8 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 										value = "1";	// No value defaults to 1
 									preprocessorDefinitions[key] = value;
 									ppDefineHistory.push_back(PPDefinition(lineCurrent, key, value));
-									definitionsChanged = true;
+									definitionsHash = HashDefinition(definitionsHash, ppDefineHistory.back());
+									lexerStateChanged = true;
 								}
 							}
 						} else if (sc.Match("undef")) {
@@ -1392,7 +1848,8 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 									const std::string key = tokens[0];
 									preprocessorDefinitions.erase(key);
 									ppDefineHistory.push_back(PPDefinition(lineCurrent, key, "", true));
-									definitionsChanged = true;
+									definitionsHash = HashDefinition(definitionsHash, ppDefineHistory.back());
+									lexerStateChanged = true;
 								}
 							}
 						}
@@ -1410,10 +1867,16 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 		continuationLine = false;
 		sc.Forward();
 	}
-	const bool rawStringsChanged = rawStringTerminators.Merge(rawSTNew, lineCurrent);
-	if (definitionsChanged || rawStringsChanged)
-		styler.ChangeLexerState(startPos, startPos + length);
+	if (rawStringTerminators.Merge(rawSTNew, lineCurrent))
+		lexerStateChanged = true;
 	sc.Complete();
+
+	// The last line lexed is only complete if lexing stopped at the start of the next line
+	if ((lineConverged < 0) && sc.atLineStart && (sc.currentPos < lengthDoc)) {
+		stateEnd = stateAtLineStart();
+	}
+	makeCheckpoints(lengthDoc, stateEnd);
+	return lineConverged;
 }
 
 // Store both the current line's fold level and the next lines in the
@@ -188,6 +188,61 @@ void AutoComplete::SetList(const char *list) {
 	lb->SetList(sortedList.c_str(), separator, typesep);
 }
 
+struct ItemSorter {
+	AutoComplete *ac;
+	const std::vector<const char *> &items;
+	const std::vector<int> &lengths;
+
+	ItemSorter(AutoComplete *ac_, const std::vector<const char *> &items_, const std::vector<int> &lengths_) :
+		ac(ac_), items(items_), lengths(lengths_) {
+	}
+
+	bool operator()(int a, int b) const {
+		const int len = std::min(lengths[a], lengths[b]);
+		int cmp;
+		if (ac->ignoreCase)
+			cmp = CompareNCaseInsensitive(items[a], items[b], len);
+		else
+			cmp = strncmp(items[a], items[b], len);
+		if (cmp == 0)
+			cmp = lengths[a] - lengths[b];
+		return cmp < 0;
+	}
+};
+
+void AutoComplete::SetItems(const char *const *items) {
+	// Items arrive already split so only need sorting when asked for
+	std::vector<const char *> words;
+	std::vector<int> lengths;
+	for (size_t i = 0; items[i]; i++) {
+		const char *typeSep = strchr(items[i], typesep);
+		words.push_back(items[i]);
+		lengths.push_back(static_cast<int>(typeSep ? typeSep - items[i] : strlen(items[i])));
+	}
+
+	sortMatrix.clear();
+	for (int i = 0; i < static_cast<int>(words.size()); ++i)
+		sortMatrix.push_back(i);
+	if (autoSort != SC_ORDER_PRESORTED) {
+		std::sort(sortMatrix.begin(), sortMatrix.end(), ItemSorter(this, words, lengths));
+	}
+
+	lb->Clear();
+	std::string item;
+	for (size_t i = 0; i < words.size(); ++i) {
+		// SC_ORDER_CUSTOM keeps the given order and looks up through sortMatrix
+		const int index = (autoSort == SC_ORDER_PERFORMSORT) ? sortMatrix[i] : static_cast<int>(i);
+		const int lenWord = std::min(lengths[index], maxItemLen - 1);
+		const char *typeSep = words[index] + lengths[index];
+		item.assign(words[index], lenWord);
+		lb->Append(&item[0], *typeSep ? atoi(typeSep + 1) : -1);
+	}
+	if (autoSort == SC_ORDER_PERFORMSORT) {
+		for (int i = 0; i < static_cast<int>(sortMatrix.size()); ++i)
+			sortMatrix[i] = i;
+	}
+}
+
 int AutoComplete::GetSelection() const {
 	return lb->GetSelection();
 }
@@ -70,6 +70,10 @@ public:
 	/// The list string contains a sequence of words separated by the separator character
 	void SetList(const char *list);
 
+	/// The items array contains words, each optionally followed by the typesep and a type,
+	/// terminated by a null pointer
+	void SetItems(const char *const *items);
+
 	/// Return the position of the currently selected list item
 	int GetSelection() const;
 
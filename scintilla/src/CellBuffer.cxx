@@ -13,10 +13,22 @@
 #include <cstdarg>
 
 #include <stdexcept>
+#include <system_error>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <functional>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include "Platform.h"
 
@@ -64,6 +76,7 @@ public:
 	virtual void SetPerLine(PerLine *pl) = 0;
 	virtual void InsertText(Sci::Line line, Sci::Position delta) = 0;
 	virtual void InsertLine(Sci::Line line, Sci::Position position, bool lineStart) = 0;
+	virtual void InsertLines(Sci::Line line, const Sci::Position *positions, size_t lines, bool lineStart) = 0;
 	virtual void SetLineStart(Sci::Line line, Sci::Position position) noexcept = 0;
 	virtual void RemoveLine(Sci::Line line) = 0;
 	virtual Sci::Line Lines() const noexcept = 0;
@@ -178,6 +191,31 @@ public:
 			perLine->InsertLine(line);
 		}
 	}
+	void InsertLines(Sci::Line line, const Sci::Position *positions, size_t lines, bool lineStart) override {
+		if (startsUTF32.Active() || startsUTF16.Active()) {
+			for (size_t i = 0; i < lines; i++) {
+				InsertLine(line + static_cast<Sci::Line>(i), positions[i], lineStart);
+			}
+			return;
+		}
+		// Convert to POS in small blocks to avoid allocating
+		const size_t blockSize = 256;
+		POS positionsAsPos[blockSize];
+		for (size_t done = 0; done < lines;) {
+			const size_t block = std::min(lines - done, blockSize);
+			std::copy(positions + done, positions + done + block, positionsAsPos);
+			starts.InsertPartitions(static_cast<POS>(line + static_cast<Sci::Line>(done)), positionsAsPos, block);
+			done += block;
+		}
+		if (perLine) {
+			for (size_t i = 0; i < lines; i++) {
+				Sci::Line linePerLine = line + static_cast<Sci::Line>(i);
+				if ((linePerLine > 0) && lineStart)
+					linePerLine--;
+				perLine->InsertLine(linePerLine);
+			}
+		}
+	}
 	void SetLineStart(Sci::Line line, Sci::Position position) noexcept override {
 		starts.SetPartitionStartPosition(static_cast<POS>(line), static_cast<POS>(position));
 	}
@@ -272,21 +310,15 @@ public:
 Action::Action() {
 	at = startAction;
 	position = 0;
+	data = nullptr;
 	lenData = 0;
 	mayCoalesce = false;
 }
 
-Action::~Action() {
-}
-
 void Action::Create(actionType at_, Sci::Position position_, const char *data_, Sci::Position lenData_, bool mayCoalesce_) {
-	data = nullptr;
 	position = position_;
 	at = at_;
-	if (lenData_) {
-		data = std::unique_ptr<char []>(new char[lenData_]);
-		memcpy(&data[0], data_, lenData_);
-	}
+	data = data_;
 	lenData = lenData_;
 	mayCoalesce = mayCoalesce_;
 }
@@ -296,6 +328,98 @@ void Action::Clear() {
 	lenData = 0;
 }
 
+UndoArena::UndoArena() : allocated(0) {
+}
+
+UndoArena::~UndoArena() {
+}
+
+// Copies s to the end of the arena, starting a new block when the last one is full.
+// Text longer than a block gets a block of its own.
+const char *UndoArena::Append(const char *s, size_t length) {
+	if (length == 0) {
+		return nullptr;
+	}
+	if (blocks.empty() || (blocks.back().capacity - blocks.back().used < length)) {
+		const size_t capacity = std::max<size_t>(blockSize, length);
+		blocks.push_back(Block{std::unique_ptr<char[]>(new char[capacity]), capacity, 0});
+		allocated += capacity;
+	}
+	Block &block = blocks.back();
+	char *text = block.text.get() + block.used;
+	memcpy(text, s, length);
+	block.used += length;
+	return text;
+}
+
+// Whether appending length bytes would place them directly after end.
+bool UndoArena::Extends(const char *end, size_t length) const noexcept {
+	if (blocks.empty()) {
+		return false;
+	}
+	const Block &block = blocks.back();
+	return (end == block.text.get() + block.used) && (block.capacity - block.used >= length);
+}
+
+// Discards all text after end, which is the end of the last text still referenced.
+void UndoArena::Truncate(const char *end) {
+	if (!end) {
+		Clear();
+		return;
+	}
+	while (!blocks.empty()) {
+		Block &block = blocks.back();
+		if ((end > block.text.get()) && (end <= block.text.get() + block.used)) {
+			block.used = end - block.text.get();
+			return;
+		}
+		allocated -= block.capacity;
+		blocks.pop_back();
+	}
+}
+
+// Frees the text before start, which is the first text still referenced. The blocks before
+// the one containing start are freed and the text of that block from start on is moved to
+// the beginning of a block, calling relocate(from, to, length) before the old copy goes away.
+// The last block keeps its size as text is still appended to it, others shrink to their text.
+template <typename Relocate>
+void UndoArena::DropBefore(const char *start, Relocate relocate) {
+	if (!start) {
+		Clear();
+		return;
+	}
+	size_t drop = 0;
+	while ((drop + 1 < blocks.size()) &&
+		!((start >= blocks[drop].text.get()) && (start < blocks[drop].text.get() + blocks[drop].used))) {
+		allocated -= blocks[drop].capacity;
+		drop++;
+	}
+	blocks.erase(blocks.begin(), blocks.begin() + drop);
+	Block &block = blocks.front();
+	const size_t offset = start - block.text.get();
+	if (offset == 0) {
+		return;
+	}
+	const size_t length = block.used - offset;
+	if (blocks.size() == 1) {
+		relocate(start, block.text.get(), length);
+		memmove(block.text.get(), start, length);
+	} else {
+		std::unique_ptr<char[]> text(new char[length]);
+		memcpy(text.get(), start, length);
+		relocate(start, text.get(), length);
+		allocated -= block.capacity - length;
+		block.text = std::move(text);
+		block.capacity = length;
+	}
+	block.used = length;
+}
+
+void UndoArena::Clear() noexcept {
+	blocks.clear();
+	allocated = 0;
+}
+
 // The undo history stores a sequence of user operations that represent the user's view of the
 // commands executed on the text.
 // Each user operation contains a sequence of text insertion and text deletion actions.
@@ -313,6 +437,8 @@ void Action::Clear() {
 // operation. If there is no outstanding BeginUndoAction call then a new operation is started
 // unless it looks as if the new action is caused by the user typing or deleting a stream of text.
 // Sequences that look like typing or deletion are coalesced into a single user operation.
+// The text of consecutive insertions, or of deletions at one position, within a user operation
+// is merged into a single action so typing does not create an action per character.
 
 UndoHistory::UndoHistory() {
 
@@ -322,6 +448,7 @@ UndoHistory::UndoHistory() {
 	undoSequenceDepth = 0;
 	savePoint = 0;
 	tentativePoint = -1;
+	memoryLimit = 0;
 
 	actions[currentAction].Create(startAction);
 }
@@ -338,6 +465,55 @@ void UndoHistory::EnsureUndoRoom() {
 	}
 }
 
+// The end of the text of the last action at or before action.
+const char *UndoHistory::DataEnd(int action) const noexcept {
+	for (; action >= 0; action--) {
+		if (actions[action].lenData) {
+			return actions[action].data + actions[action].lenData;
+		}
+	}
+	return nullptr;
+}
+
+// Discards the oldest user operations, but never the one starting at keep, until the memory
+// used is around three quarters of the limit so this is not repeated for every operation.
+void UndoHistory::DropOldest(int keep) {
+	const size_t usage = MemoryUsage();
+	const size_t target = memoryLimit / 4 * 3;
+	size_t freed = 0;
+	int drop = 0;
+	for (int act = 0; act < keep; act++) {
+		freed += sizeof(Action) + actions[act].lenData;
+		if (actions[act + 1].at == startAction) {
+			drop = act + 1;
+			if (freed + target >= usage)
+				break;
+		}
+	}
+	if (drop == 0) {
+		return;
+	}
+	actions.erase(actions.begin(), actions.begin() + drop);
+	currentAction -= drop;
+	maxAction -= drop;
+	savePoint = (savePoint >= drop) ? savePoint - drop : -1;
+	const char *firstData = nullptr;
+	for (int act = 0; act <= maxAction; act++) {
+		if (actions[act].lenData) {
+			firstData = actions[act].data;
+			break;
+		}
+	}
+	// Free the text of the dropped operations exactly, not only the blocks holding nothing else
+	arena.DropBefore(firstData, [this](const char *from, const char *to, size_t length) {
+		for (int act = 0; act <= maxAction; act++) {
+			if (actions[act].lenData && (actions[act].data >= from) && (actions[act].data < from + length)) {
+				actions[act].data = to + (actions[act].data - from);
+			}
+		}
+	});
+}
+
 const char *UndoHistory::AppendAction(actionType at, Sci::Position position, const char *data, Sci::Position lengthData,
 	bool &startSequence, bool mayCoalesce) {
 	EnsureUndoRoom();
@@ -402,12 +578,34 @@ const char *UndoHistory::AppendAction(actionType at, Sci::Position position, con
 		currentAction++;
 	}
 	startSequence = oldCurrentAction != currentAction;
-	const int actionWithData = currentAction;
-	actions[currentAction].Create(at, position, data, lengthData, mayCoalesce);
+	// Text of actions after this point could only be redone so is no longer needed
+	const char *dataEnd = DataEnd(currentAction - 1);
+	arena.Truncate(dataEnd);
+	Action &actPrevious = actions[currentAction - 1];
+	if (!startSequence && (lengthData > 0) && (at == actPrevious.at) &&
+		(currentAction != savePoint) && (currentAction != tentativePoint) &&
+		mayCoalesce && actPrevious.mayCoalesce && (actPrevious.lenData > 0) &&
+		(actPrevious.data + actPrevious.lenData == dataEnd) &&
+		(((at == insertAction) && (position == actPrevious.position + actPrevious.lenData)) ||
+		 ((at == removeAction) && (position == actPrevious.position))) &&
+		arena.Extends(dataEnd, lengthData)) {
+		// Extend the previous action whose text is at the end of the arena
+		const char *dataAppended = arena.Append(data, lengthData);
+		actPrevious.lenData += lengthData;
+		maxAction = currentAction;
+		return dataAppended;
+	}
+	const char *dataStored = arena.Append(data, lengthData);
+	actions[currentAction].Create(at, position, dataStored, lengthData, mayCoalesce);
 	currentAction++;
 	actions[currentAction].Create(startAction);
 	maxAction = currentAction;
-	return actions[actionWithData].data.get();
+	if (startSequence && memoryLimit && (MemoryUsage() > memoryLimit) && !TentativeActive()) {
+		DropOldest(oldCurrentAction);
+		// The text may have moved within the arena
+		return actions[currentAction - 1].data;
+	}
+	return dataStored;
 }
 
 void UndoHistory::BeginUndoAction() {
@@ -449,6 +647,7 @@ void UndoHistory::DeleteUndoHistory() {
 	actions[currentAction].Create(startAction);
 	savePoint = 0;
 	tentativePoint = -1;
+	arena.Clear();
 }
 
 void UndoHistory::SetSavePoint() {
@@ -529,8 +728,16 @@ void UndoHistory::CompletedRedoStep() {
 	currentAction++;
 }
 
+size_t UndoHistory::MemoryUsage() const noexcept {
+	return arena.Allocated() + (maxAction + 1) * sizeof(Action);
+}
+
 CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
 	hasStyles(hasStyles_), largeDocument(largeDocument_) {
+	externalText = nullptr;
+	externalLength = 0;
+	externalTerminated = false;
+	externalShared = false;
 	readOnly = false;
 	utf8Substance = false;
 	utf8LineEnds = 0;
@@ -542,14 +749,18 @@ CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
 }
 
 CellBuffer::~CellBuffer() {
+	ReleaseExternalText();
 }
 
 char CellBuffer::CharAt(Sci::Position position) const noexcept {
+	if (externalText) {
+		return (position >= 0 && position < externalLength) ? externalText[position] : 0;
+	}
 	return substance.ValueAt(position);
 }
 
 unsigned char CellBuffer::UCharAt(Sci::Position position) const noexcept {
-	return substance.ValueAt(position);
+	return CharAt(position);
 }
 
 void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const {
@@ -557,9 +768,13 @@ void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Positio
 		return;
 	if (position < 0)
 		return;
-	if ((position + lengthRetrieve) > substance.Length()) {
+	if ((position + lengthRetrieve) > Length()) {
 		Platform::DebugPrintf("Bad GetCharRange %d for %d of %d\n", position,
-		                      lengthRetrieve, substance.Length());
+		                      lengthRetrieve, Length());
+		return;
+	}
+	if (externalText) {
+		std::copy(externalText + position, externalText + position + lengthRetrieve, buffer);
 		return;
 	}
 	substance.GetRange(buffer, position, lengthRetrieve);
@@ -587,14 +802,27 @@ void CellBuffer::GetStyleRange(unsigned char *buffer, Sci::Position position, Sc
 }
 
 const char *CellBuffer::BufferPointer() {
+	// Text from the application need not be followed by a NUL
+	if (!externalTerminated) {
+		MaterializeExternalText();
+	}
+	if (externalText) {
+		return externalText;
+	}
 	return substance.BufferPointer();
 }
 
 const char *CellBuffer::RangePointer(Sci::Position position, Sci::Position rangeLength) {
+	if (externalText) {
+		return externalText + position;
+	}
 	return substance.RangePointer(position, rangeLength);
 }
 
 Sci::Position CellBuffer::GapPosition() const {
+	if (externalText) {
+		return externalLength;
+	}
 	return substance.GapPosition();
 }
 
@@ -654,7 +882,7 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 		if (collectingUndo) {
 			// Save into the undo/redo stack, but only the characters - not the formatting
 			// The gap would be moved to position anyway for the deletion so this doesn't cost extra
-			data = substance.RangePointer(position, deleteLength);
+			data = RangePointer(position, deleteLength);
 			data = uh.AppendAction(removeAction, position, data, deleteLength, startSequence);
 		}
 
@@ -664,6 +892,9 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 }
 
 Sci::Position CellBuffer::Length() const noexcept {
+	if (externalText) {
+		return externalLength;
+	}
 	return substance.Length();
 }
 
@@ -674,6 +905,88 @@ void CellBuffer::Allocate(Sci::Position newSize) {
 	}
 }
 
+namespace {
+
+// Deleter for external text that the application does not need to hear about
+void ReleaseNothing(void *) noexcept {
+}
+
+}
+
+// Show length bytes of text owned by the application without copying them, as long as
+// the buffer isn't modified. The buffer must be empty. The application has to keep
+// text unchanged until release(releaseData) is called, which happens on the first
+// modification when the text is copied or when the buffer is destroyed.
+void CellBuffer::SetExternalText(const char *text, Sci::Position length, void (*release)(void *), void *releaseData) {
+	// Calls release straight away if the owner can not be allocated
+	std::shared_ptr<void> owner(releaseData, release ? release : ReleaseNothing);
+	UseExternalText(text, length, false, std::move(owner));
+}
+
+// Whether the text shown is still the application's, from SetExternalText, either directly or
+// through ShareText. Text only shared with a cloned buffer belongs to the buffers.
+bool CellBuffer::HasExternalText() const noexcept {
+	return (externalText != nullptr) && !externalShared;
+}
+
+// Let clone, an empty buffer, show the same text without copying it. Both buffers use the
+// text until they are modified, when each copies it into its own gap buffer, and the text
+// is freed when neither uses it any more. The clone gets the same undo memory limit.
+// Moving this buffer's text into the shared block means this buffer pays for a copy on its
+// next modification too, unless by then the clone no longer uses the block, which is then
+// taken back without copying.
+void CellBuffer::ShareText(CellBuffer &clone) {
+	if (!externalText && (substance.Length() > 0)) {
+		// Move the text out of the gap buffer so that both buffers can share it
+		std::shared_ptr<std::vector<char>> text = std::make_shared<std::vector<char>>();
+		*text = substance.Extract();
+		externalText = text->data();
+		externalLength = text->size() - 1;
+		externalTerminated = true;
+		externalOwner = text;
+		externalShared = true;
+	}
+	if (externalText) {
+		clone.UseExternalText(externalText, externalLength, externalTerminated, externalOwner);
+		clone.externalShared = externalShared;
+	}
+	clone.SetUndoMemoryLimit(GetUndoMemoryLimit());
+}
+
+void CellBuffer::UseExternalText(const char *text, Sci::Position length, bool terminated, std::shared_ptr<void> owner) {
+	PLATFORM_ASSERT(Length() == 0);
+	externalText = text;
+	externalLength = length;
+	externalTerminated = terminated;
+	externalOwner = std::move(owner);
+	if (hasStyles) {
+		style.InsertValue(0, length, 0);
+	}
+	ResetLineEnds();
+}
+
+void CellBuffer::MaterializeExternalText() {
+	if (externalText) {
+		if (externalShared && (externalOwner.use_count() == 1)) {
+			// No other buffer uses the shared text so it becomes the gap buffer again
+			substance.Adopt(std::move(*static_cast<std::vector<char> *>(externalOwner.get())), externalLength);
+		} else {
+			substance.InsertFromArray(0, externalText, 0, externalLength);
+		}
+		ReleaseExternalText();
+	}
+}
+
+void CellBuffer::ReleaseExternalText() noexcept {
+	if (externalText) {
+		externalText = nullptr;
+		externalLength = 0;
+		externalTerminated = false;
+		externalOwner.reset();
+		externalShared = false;
+	}
+}
+
 void CellBuffer::SetUTF8Substance(bool utf8Substance_) {
 	if (utf8Substance != utf8Substance_) {
 		utf8Substance = utf8Substance_;
@@ -690,21 +1003,91 @@ void CellBuffer::SetLineEndTypes(int utf8LineEnds_) {
 	}
 }
 
+namespace {
+
+int CountTrailingZeros(unsigned int mask) noexcept {
+#if defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+bool IsLineEndCandidate(unsigned char ch, bool utf8LineEnds) noexcept {
+	// NEL, LS and PS are recognised by their last byte: 0x85, 0xA8 and 0xA9
+	return (ch == '\r') || (ch == '\n') ||
+		(utf8LineEnds && ((ch == 0x85) || ((ch | 1) == 0xA9)));
+}
+
+// Find the first byte in [s, end) that may end a line so that the bytes between
+// line ends can be skipped in blocks.
+const char *FindLineEndCandidate(const char *s, const char *end, bool utf8LineEnds) noexcept {
+#if defined(__AVX2__)
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i nel = _mm256_set1_epi8(static_cast<char>(0x85));
+	const __m256i sep = _mm256_set1_epi8(static_cast<char>(0xA9));
+	const __m256i one = _mm256_set1_epi8(1);
+	while (end - s >= 32) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+		__m256i found = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), _mm256_cmpeq_epi8(chunk, lf));
+		if (utf8LineEnds) {
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi8(chunk, nel));
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi8(_mm256_or_si256(chunk, one), sep));
+		}
+		const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(found));
+		if (mask) {
+			return s + CountTrailingZeros(mask);
+		}
+		s += 32;
+	}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i nel = _mm_set1_epi8(static_cast<char>(0x85));
+	const __m128i sep = _mm_set1_epi8(static_cast<char>(0xA9));
+	const __m128i one = _mm_set1_epi8(1);
+	while (end - s >= 16) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+		__m128i found = _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf));
+		if (utf8LineEnds) {
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, nel));
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(_mm_or_si128(chunk, one), sep));
+		}
+		const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(found));
+		if (mask) {
+			return s + CountTrailingZeros(mask);
+		}
+		s += 16;
+	}
+#endif
+	while ((s < end) && !IsLineEndCandidate(*s, utf8LineEnds)) {
+		s++;
+	}
+	return s;
+}
+
+}
+
 bool CellBuffer::ContainsLineEnd(const char *s, Sci::Position length) const {
-	unsigned char chBeforePrev = 0;
-	unsigned char chPrev = 0;
-	for (Sci::Position i = 0; i < length; i++) {
-		const unsigned char ch = s[i];
+	const char *end = s + length;
+	for (const char *p = FindLineEndCandidate(s, end, utf8LineEnds != 0); p < end;
+		p = FindLineEndCandidate(p + 1, end, utf8LineEnds != 0)) {
+		const unsigned char ch = *p;
 		if ((ch == '\r') || (ch == '\n')) {
 			return true;
-		} else if (utf8LineEnds) {
-			const unsigned char back3[3] = { chBeforePrev, chPrev, ch };
-			if (UTF8IsSeparator(back3) || UTF8IsNEL(back3 + 1)) {
-				return true;
-			}
 		}
-		chBeforePrev = chPrev;
-		chPrev = ch;
+		const Sci::Position i = p - s;
+		const unsigned char back3[3] = {
+			static_cast<unsigned char>((i >= 2) ? s[i - 2] : 0),
+			static_cast<unsigned char>((i >= 1) ? s[i - 1] : 0),
+			ch
+		};
+		if (UTF8IsSeparator(back3) || UTF8IsNEL(back3 + 1)) {
+			return true;
+		}
 	}
 	return false;
 }
@@ -807,10 +1190,10 @@ void CellBuffer::RemoveLine(Sci::Line line) {
 
 bool CellBuffer::UTF8LineEndOverlaps(Sci::Position position) const {
 	const unsigned char bytes[] = {
-		static_cast<unsigned char>(substance.ValueAt(position-2)),
-		static_cast<unsigned char>(substance.ValueAt(position-1)),
-		static_cast<unsigned char>(substance.ValueAt(position)),
-		static_cast<unsigned char>(substance.ValueAt(position+1)),
+		UCharAt(position-2),
+		UCharAt(position-1),
+		UCharAt(position),
+		UCharAt(position+1),
 	};
 	return UTF8IsSeparator(bytes) || UTF8IsSeparator(bytes+1) || UTF8IsNEL(bytes+1);
 }
@@ -824,7 +1207,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 			if (posBack < 0) {
 				return false;
 			}
-			back.insert(0, 1, substance.ValueAt(posBack));
+			back.insert(0, 1, CharAt(posBack));
 			if (!UTF8IsTrailByte(back.front())) {
 				if (i > 0) {
 					// Have reached a non-trail
@@ -838,7 +1221,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 		}
 	}
 	if (position < Length()) {
-		const unsigned char fore = substance.ValueAt(position);
+		const unsigned char fore = UCharAt(position);
 		if (UTF8IsTrailByte(fore)) {
 			return false;
 		}
@@ -846,6 +1229,43 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const {
 	return true;
 }
 
+namespace {
+
+// Texts from this length on have their line ends found on several threads
+constexpr Sci::Position lengthParallelLineScan = 16 * 1024 * 1024;
+
+// Append the starts of the lines following each line end in [first, last) of text
+// to lineStarts. A CR LF must not be split by first or last.
+void CollectLineStarts(const char *text, Sci::Position first, Sci::Position last, bool utf8LineEnds,
+	std::vector<Sci::Position> &lineStarts) {
+	const char *end = text + last;
+	for (const char *p = FindLineEndCandidate(text + first, end, utf8LineEnds); p < end;
+		p = FindLineEndCandidate(p + 1, end, utf8LineEnds)) {
+		const Sci::Position i = p - text;
+		const unsigned char ch = *p;
+		if (ch == '\r') {
+			lineStarts.push_back(i + 1);
+		} else if (ch == '\n') {
+			if ((i > first) && (text[i - 1] == '\r')) {
+				lineStarts.back() = i + 1;
+			} else {
+				lineStarts.push_back(i + 1);
+			}
+		} else {
+			const unsigned char back3[3] = {
+				(i >= 2) ? static_cast<unsigned char>(text[i - 2]) : static_cast<unsigned char>(0),
+				(i >= 1) ? static_cast<unsigned char>(text[i - 1]) : static_cast<unsigned char>(0),
+				ch
+			};
+			if (UTF8IsSeparator(back3) || UTF8IsNEL(back3+1)) {
+				lineStarts.push_back(i + 1);
+			}
+		}
+	}
+}
+
+}
+
 void CellBuffer::ResetLineEnds() {
 	// Reinitialize line data -- too much work to preserve
 	plv->Init();
@@ -855,44 +1275,148 @@ void CellBuffer::ResetLineEnds() {
 	Sci::Line lineInsert = 1;
 	const bool atLineStart = true;
 	plv->InsertText(lineInsert-1, length);
-	unsigned char chBeforePrev = 0;
-	unsigned char chPrev = 0;
-	for (Sci::Position i = 0; i < length; i++) {
-		const unsigned char ch = substance.ValueAt(position + i);
+	// Scanning contiguous text is much faster than retrieving each byte
+	const char *text = RangePointer(position, length);
+	const size_t threads = std::min(std::thread::hardware_concurrency(), 8u);
+	if ((length >= lengthParallelLineScan) && (threads > 1)) {
+		// A big text, like a file shown from a memory mapping, is split into parts that
+		// are scanned at the same time. Their line starts are then inserted in order.
+		std::vector<Sci::Position> bounds(threads + 1, length);
+		bounds[0] = 0;
+		for (size_t part = 1; part < threads; part++) {
+			Sci::Position bound = std::max(bounds[part - 1], length / static_cast<Sci::Position>(threads) * static_cast<Sci::Position>(part));
+			if ((bound > 0) && (bound < length) && (text[bound - 1] == '\r') && (text[bound] == '\n')) {
+				bound++;
+			}
+			bounds[part] = bound;
+		}
+		std::vector<std::vector<Sci::Position>> lineStarts(threads);
+		std::vector<std::thread> workers;
+		const bool utf8 = utf8LineEnds != 0;
+		try {
+			for (size_t part = 1; part < threads; part++) {
+				workers.emplace_back(CollectLineStarts, text, bounds[part], bounds[part + 1], utf8,
+					std::ref(lineStarts[part]));
+			}
+		} catch (const std::system_error &) {
+			// Threads not available so scan the remaining parts on this thread
+			for (size_t part = workers.size() + 1; part < threads; part++) {
+				CollectLineStarts(text, bounds[part], bounds[part + 1], utf8, lineStarts[part]);
+			}
+		}
+		CollectLineStarts(text, bounds[0], bounds[1], utf8, lineStarts[0]);
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+		for (const std::vector<Sci::Position> &starts : lineStarts) {
+			if (!starts.empty()) {
+				plv->InsertLines(lineInsert, starts.data(), starts.size(), atLineStart);
+				lineInsert += static_cast<Sci::Line>(starts.size());
+			}
+		}
+	} else {
+		InsertLineEnds(lineInsert, position, text, length, 0, 0, atLineStart);
+	}
+}
+
+bool CellBuffer::InsertLineEnds(Sci::Line &lineInsert, Sci::Position position, const char *s, Sci::Position length,
+	unsigned char chBeforePrev, unsigned char chPrev, bool atLineStart) {
+	// Line starts are collected and inserted in batches
+	const size_t batchSize = 1024;
+	Sci::Position lineStarts[batchSize];
+	size_t pending = 0;
+	bool containsLineEnd = false;
+	const char *end = s + length;
+	for (const char *p = FindLineEndCandidate(s, end, utf8LineEnds != 0); p < end;
+		p = FindLineEndCandidate(p + 1, end, utf8LineEnds != 0)) {
+		const Sci::Position i = p - s;
+		const unsigned char ch = *p;
+		const unsigned char chBefore = (i >= 1) ? s[i - 1] : chPrev;
+		bool lineEnd = false;
 		if (ch == '\r') {
-			InsertLine(lineInsert, (position + i) + 1, atLineStart);
-			lineInsert++;
+			lineEnd = true;
 		} else if (ch == '\n') {
-			if (chPrev == '\r') {
+			if (chBefore == '\r') {
 				// Patch up what was end of line
-				plv->SetLineStart(lineInsert - 1, (position + i) + 1);
+				if (pending > 0) {
+					lineStarts[pending - 1] = (position + i) + 1;
+				} else {
+					plv->SetLineStart(lineInsert - 1, (position + i) + 1);
+				}
+				containsLineEnd = true;
 			} else {
-				InsertLine(lineInsert, (position + i) + 1, atLineStart);
-				lineInsert++;
+				lineEnd = true;
 			}
-		} else if (utf8LineEnds) {
-			const unsigned char back3[3] = {chBeforePrev, chPrev, ch};
-			if (UTF8IsSeparator(back3) || UTF8IsNEL(back3+1)) {
-				InsertLine(lineInsert, (position + i) + 1, atLineStart);
-				lineInsert++;
+		} else {
+			const unsigned char back3[3] = {
+				(i >= 2) ? static_cast<unsigned char>(s[i - 2]) : ((i == 1) ? chPrev : chBeforePrev),
+				chBefore,
+				ch
+			};
+			lineEnd = UTF8IsSeparator(back3) || UTF8IsNEL(back3+1);
+		}
+		if (lineEnd) {
+			if (pending == batchSize) {
+				plv->InsertLines(lineInsert - static_cast<Sci::Line>(pending), lineStarts, pending, atLineStart);
+				pending = 0;
 			}
+			lineStarts[pending++] = (position + i) + 1;
+			lineInsert++;
+			containsLineEnd = true;
 		}
-		chBeforePrev = chPrev;
-		chPrev = ch;
 	}
+	if (pending > 0) {
+		plv->InsertLines(lineInsert - static_cast<Sci::Line>(pending), lineStarts, pending, atLineStart);
+	}
+	return containsLineEnd;
 }
 
 namespace {
 
+// Length of the run of ASCII bytes at the start of s, checked in blocks.
+size_t AsciiPrefixLength(const char *s, size_t len) noexcept {
+	size_t i = 0;
+#if defined(__AVX2__)
+	while (len - i >= 32) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+		const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(chunk));
+		if (mask) {
+			return i + CountTrailingZeros(mask);
+		}
+		i += 32;
+	}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	while (len - i >= 16) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+		const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(chunk));
+		if (mask) {
+			return i + CountTrailingZeros(mask);
+		}
+		i += 16;
+	}
+#endif
+	while ((i < len) && UTF8IsAscii(static_cast<unsigned char>(s[i]))) {
+		i++;
+	}
+	return i;
+}
+
 CountWidths CountCharacterWidthsUTF8(const char *s, size_t len) noexcept {
 	CountWidths cw;
 	size_t remaining = len;
 	while (remaining > 0) {
-		const int utf8Status = UTF8Classify(reinterpret_cast<const unsigned char*>(s), len);
-		const int lenChar = utf8Status & UTF8MaskWidth;
-		cw.CountChar(lenChar);
-		s += lenChar;
-		remaining -= lenChar;
+		// Runs of ASCII are counted a block at a time
+		const size_t lenAscii = AsciiPrefixLength(s, remaining);
+		cw.countBasePlane += lenAscii;
+		s += lenAscii;
+		remaining -= lenAscii;
+		if (remaining > 0) {
+			const int utf8Status = UTF8Classify(reinterpret_cast<const unsigned char*>(s), remaining);
+			const int lenChar = utf8Status & UTF8MaskWidth;
+			cw.CountChar(lenChar);
+			s += lenChar;
+			remaining -= lenChar;
+		}
 	}
 	return cw;
 }
@@ -903,6 +1427,54 @@ bool CellBuffer::MaintainingLineCharacterIndex() const noexcept {
 	return plv->LineCharacterIndex() != SC_LINECHARACTERINDEX_NONE;
 }
 
+CountWidths CellBuffer::CountCharacterWidths(Sci::Position position, Sci::Position lengthRange) const {
+	// Copied out in blocks that each end before a byte which can not continue a
+	// character started in the block, so no character is split between blocks.
+	const Sci::Position blockSize = 4096;
+	char block[blockSize];
+	CountWidths cw;
+	while (lengthRange > 0) {
+		Sci::Position lenBlock = std::min(lengthRange, blockSize);
+		if (lenBlock < lengthRange) {
+			for (Sci::Position back = 0; back < UTF8MaxBytes; back++) {
+				if (!UTF8IsTrailByte(UCharAt(position + lenBlock - back))) {
+					lenBlock -= back;
+					break;
+				}
+			}
+		}
+		GetCharRange(block, position, lenBlock);
+		const CountWidths cwBlock = CountCharacterWidthsUTF8(block, lenBlock);
+		cw.countBasePlane += cwBlock.countBasePlane;
+		cw.countOtherPlanes += cwBlock.countOtherPlanes;
+		position += lenBlock;
+		lengthRange -= lenBlock;
+	}
+	return cw;
+}
+
+Sci::Position CellBuffer::CountCodeUnits(Sci::Position position, Sci::Position lengthRange, int lineCharacterIndex) const {
+	const Sci::Position end = position + lengthRange;
+	if (plv->LineCharacterIndex() & lineCharacterIndex) {
+		// Only the parts of the first and last lines need counting
+		const Sci::Line lineFirst = plv->LineFromPosition(position) + 1;
+		const Sci::Line lineLast = plv->LineFromPosition(end);
+		if (lineFirst <= lineLast) {
+			const Sci::Position startFirst = plv->LineStart(lineFirst);
+			const Sci::Position startLast = plv->LineStart(lineLast);
+			const CountWidths cwHead = CountCharacterWidths(position, startFirst - position);
+			const CountWidths cwTail = CountCharacterWidths(startLast, end - startLast);
+			const Sci::Position middle = plv->IndexLineStart(lineLast, lineCharacterIndex) -
+				plv->IndexLineStart(lineFirst, lineCharacterIndex);
+			if (lineCharacterIndex == SC_LINECHARACTERINDEX_UTF16)
+				return cwHead.WidthUTF16() + middle + cwTail.WidthUTF16();
+			return cwHead.WidthUTF32() + middle + cwTail.WidthUTF32();
+		}
+	}
+	const CountWidths cw = CountCharacterWidths(position, lengthRange);
+	return (lineCharacterIndex == SC_LINECHARACTERINDEX_UTF16) ? cw.WidthUTF16() : cw.WidthUTF32();
+}
+
 void CellBuffer::RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast) {
 	std::string text;
 	Sci::Position posLineEnd = LineStart(lineFirst);
@@ -923,6 +1495,8 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 		return;
 	PLATFORM_ASSERT(insertLength > 0);
 
+	MaterializeExternalText();
+
 	const unsigned char chAfter = substance.ValueAt(position);
 	bool breakingUTF8LineEnd = false;
 	if (utf8LineEnds && UTF8IsTrailByte(chAfter)) {
@@ -959,37 +1533,21 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 		// Splitting up a crlf pair at position
 		InsertLine(lineInsert, position, false);
 		lineInsert++;
+		simpleInsertion = false;
 	}
 	if (breakingUTF8LineEnd) {
 		RemoveLine(lineInsert);
+		simpleInsertion = false;
 	}
-	unsigned char ch = ' ';
-	for (Sci::Position i = 0; i < insertLength; i++) {
-		ch = s[i];
-		if (ch == '\r') {
-			InsertLine(lineInsert, (position + i) + 1, atLineStart);
-			lineInsert++;
-			simpleInsertion = false;
-		} else if (ch == '\n') {
-			if (chPrev == '\r') {
-				// Patch up what was end of line
-				plv->SetLineStart(lineInsert - 1, (position + i) + 1);
-			} else {
-				InsertLine(lineInsert, (position + i) + 1, atLineStart);
-				lineInsert++;
-			}
-			simpleInsertion = false;
-		} else if (utf8LineEnds) {
-			const unsigned char back3[3] = {chBeforePrev, chPrev, ch};
-			if (UTF8IsSeparator(back3) || UTF8IsNEL(back3+1)) {
-				InsertLine(lineInsert, (position + i) + 1, atLineStart);
-				lineInsert++;
-				simpleInsertion = false;
-			}
-		}
-		chBeforePrev = chPrev;
-		chPrev = ch;
+	// A leading lf joins a cr before the insertion so moves into the previous line
+	const Sci::Line lineRecalculateStart = ((chPrev == '\r') && (s[0] == '\n') && (linePosition > 0)) ?
+		linePosition - 1 : linePosition;
+	if (InsertLineEnds(lineInsert, position, s, insertLength, chBeforePrev, chPrev, atLineStart)) {
+		simpleInsertion = false;
 	}
+	const unsigned char ch = s[insertLength - 1];
+	chBeforePrev = (insertLength >= 2) ? s[insertLength - 2] : chPrev;
+	chPrev = ch;
 	// Joining two lines where last insertion is cr and following substance starts with lf
 	if (chAfter == '\n') {
 		if (ch == '\r') {
@@ -1021,7 +1579,7 @@ void CellBuffer::BasicInsertString(Sci::Position position, const char *s, Sci::P
 			const CountWidths cw = CountCharacterWidthsUTF8(s, insertLength);
 			plv->InsertCharacters(linePosition, cw);
 		} else {
-			RecalculateIndexLineStarts(linePosition, lineInsert - 1);
+			RecalculateIndexLineStarts(lineRecalculateStart, lineInsert - 1);
 		}
 	}
 }
@@ -1030,7 +1588,10 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 	if (deleteLength == 0)
 		return;
 
+	MaterializeExternalText();
+
 	Sci::Line lineRecalculateStart = INVALID_POSITION;
+	Sci::Line lineRecalculateEnd = INVALID_POSITION;
 
 	if ((position == 0) && (deleteLength == substance.Length())) {
 		// If whole buffer is being deleted, faster to reinitialise lines data
@@ -1077,6 +1638,10 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 			plv->SetLineStart(lineRemove, position);
 			lineRemove++;
 			ignoreNL = true; 	// First \n is not real deletion
+			if (lineRecalculateStart >= 0) {
+				// The deletion now starts the following line
+				lineRecalculateEnd = linePosition + 1;
+			}
 		}
 		if (utf8LineEnds && UTF8IsTrailByte(chNext)) {
 			if (UTF8LineEndOverlaps(position)) {
@@ -1116,11 +1681,16 @@ void CellBuffer::BasicDeleteChars(Sci::Position position, Sci::Position deleteLe
 			// Using lineRemove-1 as cr ended line before start of deletion
 			RemoveLine(lineRemove - 1);
 			plv->SetLineStart(lineRemove - 1, position + 1);
+			if (lineRecalculateStart >= 0) {
+				// The remainder of the deletion's line joined the line before
+				lineRecalculateStart = std::min(lineRecalculateStart, lineRemove - 2);
+			}
 		}
 	}
 	substance.DeleteRange(position, deleteLength);
 	if (lineRecalculateStart >= 0) {
-		RecalculateIndexLineStarts(lineRecalculateStart, lineRecalculateStart);
+		lineRecalculateEnd = std::min(std::max(lineRecalculateStart, lineRecalculateEnd), plv->Lines() - 1);
+		RecalculateIndexLineStarts(lineRecalculateStart, lineRecalculateEnd);
 	}
 	if (hasStyles) {
 		style.DeleteRange(position, deleteLength);
@@ -1154,6 +1724,18 @@ void CellBuffer::DeleteUndoHistory() {
 	uh.DeleteUndoHistory();
 }
 
+void CellBuffer::SetUndoMemoryLimit(size_t limit) {
+	uh.SetMemoryLimit(limit);
+}
+
+size_t CellBuffer::GetUndoMemoryLimit() const {
+	return uh.GetMemoryLimit();
+}
+
+size_t CellBuffer::UndoMemoryUsage() const {
+	return uh.MemoryUsage();
+}
+
 bool CellBuffer::CanUndo() const {
 	return uh.CanUndo();
 }
@@ -1169,13 +1751,13 @@ const Action &CellBuffer::GetUndoStep() const {
 void CellBuffer::PerformUndoStep() {
 	const Action &actionStep = uh.GetUndoStep();
 	if (actionStep.at == insertAction) {
-		if (substance.Length() < actionStep.lenData) {
+		if (Length() < actionStep.lenData) {
 			throw std::runtime_error(
 				"CellBuffer::PerformUndoStep: deletion must be less than document length.");
 		}
 		BasicDeleteChars(actionStep.position, actionStep.lenData);
 	} else if (actionStep.at == removeAction) {
-		BasicInsertString(actionStep.position, actionStep.data.get(), actionStep.lenData);
+		BasicInsertString(actionStep.position, actionStep.data, actionStep.lenData);
 	}
 	uh.CompletedUndoStep();
 }
@@ -1195,7 +1777,7 @@ const Action &CellBuffer::GetRedoStep() const {
 void CellBuffer::PerformRedoStep() {
 	const Action &actionStep = uh.GetRedoStep();
 	if (actionStep.at == insertAction) {
-		BasicInsertString(actionStep.position, actionStep.data.get(), actionStep.lenData);
+		BasicInsertString(actionStep.position, actionStep.data, actionStep.lenData);
 	} else if (actionStep.at == removeAction) {
 		BasicDeleteChars(actionStep.position, actionStep.lenData);
 	}
@@ -23,6 +23,7 @@ public:
  * The line vector contains information about each of the lines in a cell buffer.
  */
 class ILineVector;
+struct CountWidths;
 
 enum actionType { insertAction, removeAction, startAction, containerAction };
 
@@ -33,22 +34,49 @@ class Action {
 public:
 	actionType at;
 	Sci::Position position;
-	std::unique_ptr<char[]> data;
+	/// Points into the text arena of the owning UndoHistory
+	const char *data;
 	Sci::Position lenData;
 	bool mayCoalesce;
 
+	// Actions are cheap to copy as their text is owned by the UndoArena.
 	Action();
-	// Deleted so Action objects can not be copied.
-	Action(const Action &other) = delete;
-	Action &operator=(const Action &other) = delete;
-	Action &operator=(const Action &&other) = delete;
-	// Move constructor allows vector to be resized without reallocating.
-	Action(Action &&other) noexcept = default;
-	~Action();
 	void Create(actionType at_, Sci::Position position_=0, const char *data_=nullptr, Sci::Position lenData_=0, bool mayCoalesce_=true);
 	void Clear();
 };
 
+/**
+ * The text of all actions is appended to a list of large blocks instead of
+ * being allocated separately for each action.
+ */
+class UndoArena {
+	struct Block {
+		std::unique_ptr<char[]> text;
+		size_t capacity;
+		size_t used;
+	};
+	std::vector<Block> blocks;
+	size_t allocated;
+public:
+	enum { blockSize = 0x10000 };
+
+	UndoArena();
+	// Deleted so UndoArena objects can not be copied.
+	UndoArena(const UndoArena &) = delete;
+	UndoArena(UndoArena &&) = delete;
+	void operator=(const UndoArena &) = delete;
+	void operator=(UndoArena &&) = delete;
+	~UndoArena();
+
+	const char *Append(const char *s, size_t length);
+	bool Extends(const char *end, size_t length) const noexcept;
+	void Truncate(const char *end);
+	template <typename Relocate>
+	void DropBefore(const char *start, Relocate relocate);
+	void Clear() noexcept;
+	size_t Allocated() const noexcept { return allocated; }
+};
+
 /**
  *
  */
@@ -59,8 +87,12 @@ class UndoHistory {
 	int undoSequenceDepth;
 	int savePoint;
 	int tentativePoint;
+	UndoArena arena;
+	size_t memoryLimit;
 
 	void EnsureUndoRoom();
+	const char *DataEnd(int action) const noexcept;
+	void DropOldest(int keep);
 
 public:
 	UndoHistory();
@@ -99,6 +131,12 @@ public:
 	int StartRedo();
 	const Action &GetRedoStep() const;
 	void CompletedRedoStep();
+
+	/// The oldest user operations are discarded when the memory used goes over the limit.
+	/// 0 means no limit.
+	void SetMemoryLimit(size_t limit) noexcept { memoryLimit = limit; }
+	size_t GetMemoryLimit() const noexcept { return memoryLimit; }
+	size_t MemoryUsage() const noexcept;
 };
 
 /**
@@ -112,6 +150,16 @@ private:
 	bool largeDocument;
 	SplitVector<char> substance;
 	SplitVector<char> style;
+	/// Text owned by the application or shared with a cloned buffer, used instead of
+	/// substance until the first modification
+	const char *externalText;
+	Sci::Position externalLength;
+	/// Whether a NUL follows the external text so BufferPointer can return it
+	bool externalTerminated;
+	/// Releases the external text when no buffer uses it any more
+	std::shared_ptr<void> externalOwner;
+	/// Whether externalOwner is the std::vector<char> made by ShareText
+	bool externalShared;
 	bool readOnly;
 	bool utf8Substance;
 	int utf8LineEnds;
@@ -124,8 +172,14 @@ private:
 	bool UTF8LineEndOverlaps(Sci::Position position) const;
 	bool UTF8IsCharacterBoundary(Sci::Position position) const;
 	void ResetLineEnds();
+	bool InsertLineEnds(Sci::Line &lineInsert, Sci::Position position, const char *s, Sci::Position length,
+		unsigned char chBeforePrev, unsigned char chPrev, bool atLineStart);
+	CountWidths CountCharacterWidths(Sci::Position position, Sci::Position lengthRange) const;
 	void RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast);
 	bool MaintainingLineCharacterIndex() const noexcept;
+	void UseExternalText(const char *text, Sci::Position length, bool terminated, std::shared_ptr<void> owner);
+	void MaterializeExternalText();
+	void ReleaseExternalText() noexcept;
 	/// Actions without undo
 	void BasicInsertString(Sci::Position position, const char *s, Sci::Position insertLength);
 	void BasicDeleteChars(Sci::Position position, Sci::Position deleteLength);
@@ -152,6 +206,9 @@ public:
 
 	Sci::Position Length() const noexcept;
 	void Allocate(Sci::Position newSize);
+	void SetExternalText(const char *text, Sci::Position length, void (*release)(void *), void *releaseData);
+	bool HasExternalText() const noexcept;
+	void ShareText(CellBuffer &clone);
 	void SetUTF8Substance(bool utf8Substance_);
 	int GetLineEndTypes() const { return utf8LineEnds; }
 	void SetLineEndTypes(int utf8LineEnds_);
@@ -165,6 +222,8 @@ public:
 	Sci::Position IndexLineStart(Sci::Line line, int lineCharacterIndex) const noexcept;
 	Sci::Line LineFromPosition(Sci::Position pos) const noexcept;
 	Sci::Line LineFromPositionIndex(Sci::Position pos, int lineCharacterIndex) const noexcept;
+	/// UTF-8 only: UTF-32 or UTF-16 code units in a range that starts and ends on character boundaries
+	Sci::Position CountCodeUnits(Sci::Position position, Sci::Position lengthRange, int lineCharacterIndex) const;
 	void InsertLine(Sci::Line line, Sci::Position position, bool lineStart);
 	void RemoveLine(Sci::Line line);
 	const char *InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence);
@@ -197,6 +256,9 @@ public:
 	void EndUndoAction();
 	void AddUndoAction(Sci::Position token, bool mayCoalesce);
 	void DeleteUndoHistory();
+	void SetUndoMemoryLimit(size_t limit);
+	size_t GetUndoMemoryLimit() const;
+	size_t UndoMemoryUsage() const;
 
 	/// To perform an undo, StartUndo is called to retrieve the number of steps, then UndoStep is
 	/// called that many times. Similarly for redo.
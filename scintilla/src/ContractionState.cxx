@@ -78,6 +78,7 @@ public:
 
 	bool GetExpanded(Sci::Line lineDoc) const override;
 	bool SetExpanded(Sci::Line lineDoc, bool isExpanded) override;
+	void ExpandAll() override;
 	Sci::Line ContractedNext(Sci::Line lineDocStart) const override;
 
 	int GetHeight(Sci::Line lineDoc) const override;
@@ -243,14 +244,22 @@ bool ContractionState<LINE>::SetVisible(Sci::Line lineDocStart, Sci::Line lineDo
 		Sci::Line delta = 0;
 		Check();
 		if ((lineDocStart <= lineDocEnd) && (lineDocStart >= 0) && (lineDocEnd < LinesInDoc())) {
-			for (Sci::Line line = lineDocStart; line <= lineDocEnd; line++) {
+			// Work a run of visibility at a time so lines already in the wanted state,
+			// such as the contents of nested folds, are skipped over.
+			Sci::Line line = lineDocStart;
+			while (line <= lineDocEnd) {
+				const Sci::Line lineEndRun = std::min<Sci::Line>(visible->EndRun(static_cast<LINE>(line)), lineDocEnd + 1);
 				if (GetVisible(line) != isVisible) {
-					const int heightLine = heights->ValueAt(static_cast<LINE>(line));
-					const int difference = isVisible ? heightLine : -heightLine;
-					visible->SetValueAt(static_cast<LINE>(line), isVisible ? 1 : 0);
-					displayLines->InsertText(static_cast<LINE>(line), difference);
-					delta += difference;
+					for (Sci::Line lineChange = line; lineChange < lineEndRun; lineChange++) {
+						const int heightLine = heights->ValueAt(static_cast<LINE>(lineChange));
+						const int difference = isVisible ? heightLine : -heightLine;
+						displayLines->InsertText(static_cast<LINE>(lineChange), difference);
+						delta += difference;
+					}
+					visible->FillRange(static_cast<LINE>(line), isVisible ? 1 : 0,
+						static_cast<LINE>(lineEndRun - line));
 				}
+				line = lineEndRun;
 			}
 		} else {
 			return false;
@@ -317,6 +326,14 @@ bool ContractionState<LINE>::SetExpanded(Sci::Line lineDoc, bool isExpanded) {
 	}
 }
 
+template <typename LINE>
+void ContractionState<LINE>::ExpandAll() {
+	if (!OneToOne()) {
+		expanded->FillRange(0, 1, static_cast<LINE>(LinesInDoc()));
+		Check();
+	}
+}
+
 template <typename LINE>
 Sci::Line ContractionState<LINE>::ContractedNext(Sci::Line lineDocStart) const {
 	if (OneToOne()) {
@@ -36,6 +36,7 @@ public:
 
 	virtual bool GetExpanded(Sci::Line lineDoc) const=0;
 	virtual bool SetExpanded(Sci::Line lineDoc, bool isExpanded)=0;
+	virtual void ExpandAll()=0;
 	virtual Sci::Line ContractedNext(Sci::Line lineDocStart) const=0;
 
 	virtual int GetHeight(Sci::Line lineDoc) const=0;
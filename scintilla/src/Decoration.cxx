@@ -11,6 +11,7 @@
 #include <cstdarg>
 
 #include <stdexcept>
+#include <utility>
 #include <vector>
 #include <algorithm>
 #include <memory>
@@ -101,6 +102,7 @@ public:
 
 	// Returns changed=true if some values may have changed
 	FillResult<Sci::Position> FillRange(Sci::Position position, int value, Sci::Position fillLength) override;
+	FillResult<Sci::Position> FillRanges(const Sci::Position *ranges, size_t count, int value) override;
 
 	void InsertSpace(Sci::Position position, Sci::Position insertLength) override;
 	void DeleteRange(Sci::Position position, Sci::Position deleteLength) override;
@@ -198,6 +200,56 @@ FillResult<Sci::Position> DecorationList<POS>::FillRange(Sci::Position position,
 	return fr;
 }
 
+template <typename POS>
+FillResult<Sci::Position> DecorationList<POS>::FillRanges(const Sci::Position *ranges, size_t count, int value) {
+	// Clip to the document then sort and merge into ascending start and end pairs
+	std::vector<std::pair<POS, POS>> spans;
+	spans.reserve(count);
+	bool sorted = true;
+	for (size_t i = 0; i < count; i++) {
+		const Sci::Position start = std::max<Sci::Position>(ranges[i * 2], 0);
+		const Sci::Position end = std::min(ranges[i * 2] + ranges[i * 2 + 1], lengthDocument);
+		if (start < end) {
+			if (!spans.empty() && (start < spans.back().first)) {
+				sorted = false;
+			}
+			spans.push_back(std::make_pair(static_cast<POS>(start), static_cast<POS>(end)));
+		}
+	}
+	if (spans.empty()) {
+		return FillResult<Sci::Position>{false, 0, 0};
+	}
+	if (!sorted) {
+		std::sort(spans.begin(), spans.end());
+	}
+	std::vector<POS> merged;
+	merged.reserve(spans.size() * 2);
+	for (const std::pair<POS, POS> &span : spans) {
+		if (!merged.empty() && (span.first <= merged.back())) {
+			merged.back() = std::max(merged.back(), span.second);
+		} else {
+			merged.push_back(span.first);
+			merged.push_back(span.second);
+		}
+	}
+
+	if (!current) {
+		current = DecorationFromIndicator(currentIndicator);
+		if (!current) {
+			if (value == 0) {
+				return FillResult<Sci::Position>{false, 0, 0};
+			}
+			current = Create(currentIndicator, lengthDocument);
+		}
+	}
+	const FillResult<POS> frInPOS = current->rs.FillRanges(merged.data(), merged.size() / 2, value);
+	const FillResult<Sci::Position> fr { frInPOS.changed, frInPOS.position, frInPOS.fillLength };
+	if (current->Empty()) {
+		Delete(currentIndicator);
+	}
+	return fr;
+}
+
 template <typename POS>
 void DecorationList<POS>::InsertSpace(Sci::Position position, Sci::Position insertLength) {
 	const bool atEnd = position == lengthDocument;
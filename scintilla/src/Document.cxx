@@ -297,7 +297,7 @@ void Document::TentativeUndo() {
 						modFlags |= SC_MULTILINEUNDOREDO;
 				}
 				NotifyModified(DocModification(modFlags, action.position, action.lenData,
-											   linesAdded, action.data.get()));
+											   linesAdded, action.data));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -1349,7 +1349,7 @@ Sci::Position Document::Undo() {
 						modFlags |= SC_MULTILINEUNDOREDO;
 				}
 				NotifyModified(DocModification(modFlags, action.position, action.lenData,
-											   linesAdded, action.data.get()));
+											   linesAdded, action.data));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -1409,7 +1409,7 @@ Sci::Position Document::Redo() {
 				}
 				NotifyModified(
 					DocModification(modFlags, action.position, action.lenData,
-									linesAdded, action.data.get()));
+									linesAdded, action.data));
 			}
 
 			const bool endSavePoint = cb.IsSavePoint();
@@ -1530,6 +1530,9 @@ Sci::Position Document::GetColumn(Sci::Position pos) {
 Sci::Position Document::CountCharacters(Sci::Position startPos, Sci::Position endPos) const {
 	startPos = MovePositionOutsideChar(startPos, 1, false);
 	endPos = MovePositionOutsideChar(endPos, -1, false);
+	if (SC_CP_UTF8 == dbcsCodePage) {
+		return (endPos > startPos) ? cb.CountCodeUnits(startPos, endPos - startPos, SC_LINECHARACTERINDEX_UTF32) : 0;
+	}
 	Sci::Position count = 0;
 	Sci::Position i = startPos;
 	while (i < endPos) {
@@ -1542,6 +1545,9 @@ Sci::Position Document::CountCharacters(Sci::Position startPos, Sci::Position en
 Sci::Position Document::CountUTF16(Sci::Position startPos, Sci::Position endPos) const {
 	startPos = MovePositionOutsideChar(startPos, 1, false);
 	endPos = MovePositionOutsideChar(endPos, -1, false);
+	if (SC_CP_UTF8 == dbcsCodePage) {
+		return (endPos > startPos) ? cb.CountCodeUnits(startPos, endPos - startPos, SC_LINECHARACTERINDEX_UTF16) : 0;
+	}
 	Sci::Position count = 0;
 	Sci::Position i = startPos;
 	while (i < endPos) {
@@ -1969,6 +1975,34 @@ Document::CharacterExtracted Document::ExtractCharacter(Sci::Position position)
 	}
 }
 
+namespace {
+
+// Retrieve the text from position up to end that is contiguous in the buffer so that it
+// can be scanned without moving the gap.
+const char *ContiguousRange(CellBuffer &cb, Sci::Position position, Sci::Position end,
+	Sci::Position &lengthRange) {
+	const Sci::Position gap = cb.GapPosition();
+	lengthRange = ((position < gap) && (gap < end)) ? gap - position : end - position;
+	return cb.RangePointer(position, lengthRange);
+}
+
+// Fold the ASCII characters in advance so they need not go through the case folder
+// while searching. Fails if any of them does not fold to a single ASCII character.
+bool FoldASCII(CaseFolder *pcf, char asciiFolded[0x80]) {
+	for (int ch = 0; ch < 0x80; ch++) {
+		const char mixed = static_cast<char>(ch);
+		char folded[UTF8MaxBytes * 4 + 1];
+		if ((pcf->Fold(folded, sizeof(folded), &mixed, 1) != 1) ||
+			!UTF8IsAscii(static_cast<unsigned char>(folded[0]))) {
+			return false;
+		}
+		asciiFolded[ch] = folded[0];
+	}
+	return true;
+}
+
+}
+
 /**
  * Find text in document, supporting both forward and backward
  * searches (just pass minPos > maxPos to do a backward search)
@@ -2005,7 +2039,36 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 			// Back all of a character
 			pos = NextPosition(pos, increment);
 		}
-		if (caseSensitive) {
+		if (caseSensitive && forward &&
+			(!dbcsCodePage || ((SC_CP_UTF8 == dbcsCodePage) && !UTF8IsTrailByte(search[0])))) {
+			// Any occurrence of a first byte that is not a UTF-8 trail byte starts a character,
+			// so look for it with memchr then compare the rest, a contiguous range at a time.
+			const Sci::Position endSearch = endPos - lengthFind + 1;
+			while (pos < endSearch) {
+				Sci::Position lengthRange = 0;
+				const char *range = ContiguousRange(cb, pos, endSearch, lengthRange);
+				const char *hit = static_cast<const char *>(memchr(range, search[0], lengthRange));
+				if (!hit) {
+					pos += lengthRange;
+					continue;
+				}
+				pos += hit - range;
+				bool found;
+				const Sci::Position gap = cb.GapPosition();
+				if ((pos >= gap) || ((pos + lengthFind) <= gap)) {
+					found = memcmp(cb.RangePointer(pos, lengthFind), search, lengthFind) == 0;
+				} else {
+					found = true;
+					for (int indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
+						found = CharAt(pos + indexSearch) == search[indexSearch];
+					}
+				}
+				if (found && MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+					return pos;
+				}
+				pos++;
+			}
+		} else if (caseSensitive) {
 			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			const char charStartSearch =  search[0];
 			while (forward ? (pos < endSearch) : (pos >= endSearch)) {
@@ -2028,7 +2091,26 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 				pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind);
 			char bytes[UTF8MaxBytes + 1] = "";
 			char folded[UTF8MaxBytes * maxFoldingExpansion + 1] = "";
+			char asciiFolded[0x80];
+			const bool foldingASCII = (lenSearch > 0) && FoldASCII(pcf.get(), asciiFolded);
 			while (forward ? (pos < endPos) : (pos >= endPos)) {
+				if (forward && foldingASCII) {
+					// Skip ASCII characters that can not start a match. Other characters stop
+					// the skip, so it ends at the start of a character.
+					Sci::Position lengthRange = 0;
+					const char *range = ContiguousRange(cb, pos, endPos, lengthRange);
+					Sci::Position skip = 0;
+					while (skip < lengthRange) {
+						const unsigned char ch = range[skip];
+						if (!UTF8IsAscii(ch) || (asciiFolded[ch] == searchThing[0]))
+							break;
+						skip++;
+					}
+					pos += skip;
+					if (skip == lengthRange) {
+						continue;
+					}
+				}
 				int widthFirstCharacter = 0;
 				Sci::Position posIndexDocument = pos;
 				size_t indexSearch = 0;
@@ -2048,6 +2130,16 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 						widthFirstCharacter = widthChar;
 					if ((posIndexDocument + widthChar) > limitPos)
 						break;
+					if (foldingASCII && UTF8IsAscii(leadByte)) {
+						characterMatches = asciiFolded[leadByte] == searchThing[indexSearch];
+						if (!characterMatches)
+							break;
+						posIndexDocument++;
+						indexSearch++;
+						if (indexSearch >= lenSearch)
+							break;
+						continue;
+					}
 					const size_t lenFlat = pcf->Fold(folded, sizeof(folded), bytes, widthChar);
 					// memcmp may examine lenFlat bytes in both arguments so assert it doesn't read past end of searchThing
 					assert((indexSearch + lenFlat) <= searchThing.size());
@@ -2384,6 +2476,16 @@ void SCI_METHOD Document::DecorationFillRange(Sci_Position position, int value,
 	}
 }
 
+// Fills many ranges with a single rebuild of the indicator and a single notification
+void Document::DecorationFillRanges(const Sci::Position *ranges, size_t count, int value) {
+	const FillResult<Sci::Position> fr = decorations->FillRanges(ranges, count, value);
+	if (fr.changed) {
+		const DocModification mh(SC_MOD_CHANGEINDICATOR | SC_PERFORMED_USER,
+							fr.position, fr.fillLength);
+		NotifyModified(mh);
+	}
+}
+
 bool Document::AddWatcher(DocWatcher *watcher, void *userData) {
 	const WatcherWithUserData wwud(watcher, userData);
 	std::vector<WatcherWithUserData>::iterator it =
@@ -2633,12 +2735,68 @@ Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxRe
 	return - 1;
 }
 
+#ifndef NO_CXX11_REGEX
+
+/**
+ * Recently used std::regex patterns, compiled, so that repeated searches such as
+ * find next and replace all do not construct the same regex each time.
+ */
+class Cxx11RegexCache {
+public:
+	struct Entry {
+		std::string pattern;
+		bool caseSensitive;
+		bool unicode;
+		std::regex regexp;
+		std::wregex wregexp;
+		Entry(const char *pattern_, bool caseSensitive_, bool unicode_);
+	};
+	/// Returns the compiled pattern, compiling it if needed. Throws std::regex_error.
+	const Entry &Find(const char *pattern, bool caseSensitive, bool unicode);
+private:
+	enum { maxEntries = 8 };
+	std::vector<std::unique_ptr<Entry>> entries;	// Most recently used first
+};
+
+Cxx11RegexCache::Entry::Entry(const char *pattern_, bool caseSensitive_, bool unicode_) :
+	pattern(pattern_), caseSensitive(caseSensitive_), unicode(unicode_) {
+	std::regex::flag_type flagsRe = std::regex::ECMAScript;
+	// Flags that apper to have no effect:
+	// | std::regex::collate | std::regex::extended;
+	if (!caseSensitive)
+		flagsRe = flagsRe | std::regex::icase;
+	if (unicode) {
+		const std::wstring ws = WStringFromUTF8(pattern.c_str(), pattern.length());
+		wregexp.assign(ws, flagsRe);
+	} else {
+		regexp.assign(pattern, flagsRe);
+	}
+}
+
+const Cxx11RegexCache::Entry &Cxx11RegexCache::Find(const char *pattern, bool caseSensitive, bool unicode) {
+	for (size_t i = 0; i < entries.size(); i++) {
+		if ((entries[i]->caseSensitive == caseSensitive) && (entries[i]->unicode == unicode) &&
+			(entries[i]->pattern == pattern)) {
+			std::rotate(entries.begin(), entries.begin() + i, entries.begin() + i + 1);
+			return *entries.front();
+		}
+	}
+	std::unique_ptr<Entry> entry(new Entry(pattern, caseSensitive, unicode));
+	if (entries.size() >= maxEntries)
+		entries.pop_back();
+	entries.insert(entries.begin(), std::move(entry));
+	return *entries.front();
+}
+
+#endif
+
 /**
  * Implementation of RegexSearchBase for the default built-in regular expression engine
  */
 class BuiltinRegex : public RegexSearchBase {
 public:
-	explicit BuiltinRegex(CharClassify *charClassTable) : search(charClassTable) {}
+	explicit BuiltinRegex(CharClassify *charClassTable) :
+		charClass(charClassTable), search(charClassTable), compiledCaseSensitive(false), compiledPosix(false) {}
 	BuiltinRegex(const BuiltinRegex &) = delete;
 	BuiltinRegex(BuiltinRegex &&) = delete;
 	BuiltinRegex &operator=(const BuiltinRegex &) = delete;
@@ -2652,8 +2810,19 @@ public:
 	const char *SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) override;
 
 private:
+	CharClassify *charClass;
 	RESearch search;
 	std::string substituted;
+	// The pattern compiled into search, with the options and word characters it depends on,
+	// so it is only compiled again when one of them changes.
+	std::string compiledPattern;
+	bool compiledCaseSensitive;
+	bool compiledPosix;
+	std::string compiledWordChars;
+#ifndef NO_CXX11_REGEX
+	Cxx11RegexCache cxx11Cache;
+#endif
+	bool CompileRE(const char *s, Sci::Position length, bool caseSensitive, bool posix);
 };
 
 namespace {
@@ -2699,13 +2868,58 @@ public:
 	}
 };
 
+// The document text as the two contiguous parts either side of the gap so that
+// searches read characters directly instead of calling Document::CharAt for each.
+// Only valid while the document is not modified.
+class GapText {
+	const char *before;
+	const char *after;	// Offset so that it is indexed by document position
+	Sci::Position gap;
+	Sci::Position length;
+public:
+	explicit GapText(Document *doc) : before(nullptr), after(nullptr) {
+		length = doc->Length();
+		gap = std::min(doc->GapPosition(), length);
+		// Neither range crosses the gap so this does not rearrange the buffer.
+		if (gap > 0)
+			before = doc->RangePointer(0, gap);
+		if (gap < length)
+			after = doc->RangePointer(gap, length - gap) - gap;
+	}
+	Sci::Position Length() const noexcept {
+		return length;
+	}
+	char CharAt(Sci::Position position) const noexcept {
+		if (position < gap)
+			return (position >= 0) ? before[position] : 0;
+		return (position < length) ? after[position] : 0;
+	}
+	// Position of the first ch in [start, end) or -1. Scans each side of the gap with memchr.
+	Sci::Position Find(char ch, Sci::Position start, Sci::Position end) const noexcept {
+		end = std::min(end, length);
+		if (start < gap) {
+			const Sci::Position endBefore = std::min(end, gap);
+			const void *found = memchr(before + start, static_cast<unsigned char>(ch), endBefore - start);
+			if (found)
+				return static_cast<const char *>(found) - before;
+			start = endBefore;
+		}
+		if (start < end) {
+			const void *found = memchr(after + start, static_cast<unsigned char>(ch), end - start);
+			if (found)
+				return static_cast<const char *>(found) - after;
+		}
+		return -1;
+	}
+};
+
 // Define a way for the Regular Expression code to access the document
 class DocumentIndexer : public CharacterIndexer {
-	Document *pdoc;
+	const GapText *text;
 	Sci::Position end;
 public:
-	DocumentIndexer(Document *pdoc_, Sci::Position end_) noexcept :
-		pdoc(pdoc_), end(end_) {
+	DocumentIndexer(const GapText *text_, Sci::Position end_) noexcept :
+		text(text_), end(end_) {
 	}
 
 	DocumentIndexer(const DocumentIndexer &) = delete;
@@ -2716,10 +2930,10 @@ public:
 	~DocumentIndexer() override = default;
 
 	char CharAt(Sci::Position index) const noexcept override {
-		if (index < 0 || index >= end)
+		if (index >= end)
 			return 0;
 		else
-			return pdoc->CharAt(index);
+			return text->CharAt(index);
 	}
 };
 
@@ -2733,23 +2947,23 @@ public:
 	typedef char* pointer;
 	typedef char& reference;
 
-	const Document *doc;
+	const GapText *text;
 	Sci::Position position;
 
-	ByteIterator(const Document *doc_=nullptr, Sci::Position position_=0) noexcept :
-		doc(doc_), position(position_) {
+	ByteIterator(const Document * = nullptr, const GapText *text_=nullptr, Sci::Position position_=0) noexcept :
+		text(text_), position(position_) {
 	}
 	ByteIterator(const ByteIterator &other) noexcept {
-		doc = other.doc;
+		text = other.text;
 		position = other.position;
 	}
 	ByteIterator(ByteIterator &&other) noexcept {
-		doc = other.doc;
+		text = other.text;
 		position = other.position;
 	}
 	ByteIterator &operator=(const ByteIterator &other) noexcept {
 		if (this != &other) {
-			doc = other.doc;
+			text = other.text;
 			position = other.position;
 		}
 		return *this;
@@ -2757,7 +2971,7 @@ public:
 	ByteIterator &operator=(ByteIterator &&) noexcept = default;
 	~ByteIterator() = default;
 	char operator*() const noexcept {
-		return doc->CharAt(position);
+		return text->CharAt(position);
 	}
 	ByteIterator &operator++() noexcept {
 		position++;
@@ -2773,10 +2987,10 @@ public:
 		return *this;
 	}
 	bool operator==(const ByteIterator &other) const noexcept {
-		return doc == other.doc && position == other.position;
+		return text == other.text && position == other.position;
 	}
 	bool operator!=(const ByteIterator &other) const noexcept {
-		return doc != other.doc || position != other.position;
+		return text != other.text || position != other.position;
 	}
 	Sci::Position Pos() const noexcept {
 		return position;
@@ -2805,6 +3019,7 @@ public:
 class UTF8Iterator {
 	// These 3 fields determine the iterator position and are used for comparisons
 	const Document *doc;
+	const GapText *text;
 	Sci::Position position;
 	size_t characterIndex;
 	// Remaining fields are derived from the determining fields so are excluded in comparisons
@@ -2818,8 +3033,8 @@ public:
 	typedef wchar_t* pointer;
 	typedef wchar_t& reference;
 
-	UTF8Iterator(const Document *doc_=nullptr, Sci::Position position_=0) noexcept :
-		doc(doc_), position(position_), characterIndex(0), lenBytes(0), lenCharacters(0), buffered{} {
+	UTF8Iterator(const Document *doc_=nullptr, const GapText *text_=nullptr, Sci::Position position_=0) noexcept :
+		doc(doc_), text(text_), position(position_), characterIndex(0), lenBytes(0), lenCharacters(0), buffered{} {
 		buffered[0] = 0;
 		buffered[1] = 0;
 		if (doc) {
@@ -2828,6 +3043,7 @@ public:
 	}
 	UTF8Iterator(const UTF8Iterator &other) noexcept : buffered{} {
 		doc = other.doc;
+		text = other.text;
 		position = other.position;
 		characterIndex = other.characterIndex;
 		lenBytes = other.lenBytes;
@@ -2839,6 +3055,7 @@ public:
 	UTF8Iterator &operator=(const UTF8Iterator &other) noexcept {
 		if (this != &other) {
 			doc = other.doc;
+			text = other.text;
 			position = other.position;
 			characterIndex = other.characterIndex;
 			lenBytes = other.lenBytes;
@@ -2908,6 +3125,13 @@ public:
 	}
 private:
 	void ReadCharacter() noexcept {
+		const unsigned char leadByte = text->CharAt(position);
+		if (UTF8IsAscii(leadByte)) {
+			lenBytes = 1;
+			lenCharacters = 1;
+			buffered[0] = leadByte;
+			return;
+		}
 		const Document::CharacterExtracted charExtracted = doc->ExtractCharacter(position);
 		lenBytes = charExtracted.widthBytes;
 		if (charExtracted.character == unicodeReplacementChar) {
@@ -2925,6 +3149,7 @@ private:
 
 class UTF8Iterator {
 	const Document *doc;
+	const GapText *text;
 	Sci::Position position;
 public:
 	typedef std::bidirectional_iterator_tag iterator_category;
@@ -2933,17 +3158,19 @@ public:
 	typedef wchar_t* pointer;
 	typedef wchar_t& reference;
 
-	UTF8Iterator(const Document *doc_=nullptr, Sci::Position position_=0) noexcept :
-		doc(doc_), position(position_) {
+	UTF8Iterator(const Document *doc_=nullptr, const GapText *text_=nullptr, Sci::Position position_=0) noexcept :
+		doc(doc_), text(text_), position(position_) {
 	}
 	UTF8Iterator(const UTF8Iterator &other) noexcept {
 		doc = other.doc;
+		text = other.text;
 		position = other.position;
 	}
 	UTF8Iterator(UTF8Iterator &&other) noexcept = default;
 	UTF8Iterator &operator=(const UTF8Iterator &other) noexcept {
 		if (this != &other) {
 			doc = other.doc;
+			text = other.text;
 			position = other.position;
 		}
 		return *this;
@@ -2951,20 +3178,28 @@ public:
 	UTF8Iterator &operator=(UTF8Iterator &&) noexcept = default;
 	~UTF8Iterator() = default;
 	wchar_t operator*() const noexcept {
+		// ASCII is most common and needs no decoding
+		const unsigned char leadByte = text->CharAt(position);
+		if (UTF8IsAscii(leadByte))
+			return leadByte;
 		const Document::CharacterExtracted charExtracted = doc->ExtractCharacter(position);
 		return charExtracted.character;
 	}
 	UTF8Iterator &operator++() noexcept {
-		position = doc->NextPosition(position, 1);
+		Forward();
 		return *this;
 	}
 	UTF8Iterator operator++(int) noexcept {
 		UTF8Iterator retVal(*this);
-		position = doc->NextPosition(position, 1);
+		Forward();
 		return retVal;
 	}
 	UTF8Iterator &operator--() noexcept {
-		position = doc->NextPosition(position, -1);
+		// An ASCII byte is never part of a multi-byte character
+		if ((position > 0) && UTF8IsAscii(static_cast<unsigned char>(text->CharAt(position - 1))))
+			position--;
+		else
+			position = doc->NextPosition(position, -1);
 		return *this;
 	}
 	bool operator==(const UTF8Iterator &other) const noexcept {
@@ -2979,6 +3214,13 @@ public:
 	Sci::Position PosRoundUp() const noexcept {
 		return position;
 	}
+private:
+	void Forward() noexcept {
+		if ((position < text->Length()) && UTF8IsAscii(static_cast<unsigned char>(text->CharAt(position))))
+			position++;
+		else
+			position = doc->NextPosition(position, 1);
+	}
 };
 
 #endif
@@ -2993,7 +3235,7 @@ std::regex_constants::match_flag_type MatchFlags(const Document *doc, Sci::Posit
 }
 
 template<typename Iterator, typename Regex>
-bool MatchOnLines(const Document *doc, const Regex &regexp, const RESearchRange &resr, RESearch &search) {
+bool MatchOnLines(const Document *doc, const GapText &text, const Regex &regexp, const RESearchRange &resr, RESearch &search) {
 	std::match_results<Iterator> match;
 
 	// MSVC and libc++ have problems with ^ and $ matching line ends inside a range.
@@ -3004,8 +3246,8 @@ bool MatchOnLines(const Document *doc, const Regex &regexp, const RESearchRange
 	// If multiline regex worked well then the line by line iteration could be removed
 	// for the forwards case and replaced with the following 4 lines:
 #ifdef REGEX_MULTILINE
-	Iterator itStart(doc, resr.startPos);
-	Iterator itEnd(doc, resr.endPos);
+	Iterator itStart(doc, &text, resr.startPos);
+	Iterator itEnd(doc, &text, resr.endPos);
 	const std::regex_constants::match_flag_type flagsMatch = MatchFlags(doc, resr.startPos, resr.endPos);
 	const bool matched = std::regex_search(itStart, itEnd, match, regexp, flagsMatch);
 #else
@@ -3013,15 +3255,15 @@ bool MatchOnLines(const Document *doc, const Regex &regexp, const RESearchRange
 	bool matched = false;
 	for (Sci::Line line = resr.lineRangeStart; line != resr.lineRangeBreak; line += resr.increment) {
 		const Range lineRange = resr.LineRange(line);
-		Iterator itStart(doc, lineRange.start);
-		Iterator itEnd(doc, lineRange.end);
+		Iterator itStart(doc, &text, lineRange.start);
+		Iterator itEnd(doc, &text, lineRange.end);
 		std::regex_constants::match_flag_type flagsMatch = MatchFlags(doc, lineRange.start, lineRange.end);
 		matched = std::regex_search(itStart, itEnd, match, regexp, flagsMatch);
 		// Check for the last match on this line.
 		if (matched) {
 			if (resr.increment == -1) {
 				while (matched) {
-					Iterator itNext(doc, match[0].second.PosRoundUp());
+					Iterator itNext(doc, &text, match[0].second.PosRoundUp());
 					flagsMatch = MatchFlags(doc, itNext.Pos(), lineRange.end);
 					std::match_results<Iterator> matchNext;
 					matched = std::regex_search(itNext, itEnd, matchNext, regexp, flagsMatch);
@@ -3046,38 +3288,30 @@ bool MatchOnLines(const Document *doc, const Regex &regexp, const RESearchRange
 			const Sci::Position lenMatch = search.eopat[co] - search.bopat[co];
 			search.pat[co].resize(lenMatch);
 			for (Sci::Position iPos = 0; iPos < lenMatch; iPos++) {
-				search.pat[co][iPos] = doc->CharAt(iPos + search.bopat[co]);
+				search.pat[co][iPos] = text.CharAt(iPos + search.bopat[co]);
 			}
 		}
 	}
 	return matched;
 }
 
-Sci::Position Cxx11RegexFindText(const Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
-	bool caseSensitive, Sci::Position *length, RESearch &search) {
+Sci::Position Cxx11RegexFindText(Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *s,
+	bool caseSensitive, Sci::Position *length, RESearch &search, Cxx11RegexCache &cache) {
 	const RESearchRange resr(doc, minPos, maxPos);
 	try {
 		//ElapsedPeriod ep;
-		std::regex::flag_type flagsRe = std::regex::ECMAScript;
-		// Flags that apper to have no effect:
-		// | std::regex::collate | std::regex::extended;
-		if (!caseSensitive)
-			flagsRe = flagsRe | std::regex::icase;
-
 		// Clear the RESearch so can fill in matches
 		search.Clear();
 
-		bool matched = false;
-		if (SC_CP_UTF8 == doc->dbcsCodePage) {
-			const std::wstring ws = WStringFromUTF8(s, strlen(s));
-			std::wregex regexp;
-			regexp.assign(ws, flagsRe);
-			matched = MatchOnLines<UTF8Iterator>(doc, regexp, resr, search);
+		const bool unicode = SC_CP_UTF8 == doc->dbcsCodePage;
+		const Cxx11RegexCache::Entry &compiled = cache.Find(s, caseSensitive, unicode);
 
+		const GapText text(doc);
+		bool matched = false;
+		if (unicode) {
+			matched = MatchOnLines<UTF8Iterator>(doc, text, compiled.wregexp, resr, search);
 		} else {
-			std::regex regexp;
-			regexp.assign(s, flagsRe);
-			matched = MatchOnLines<ByteIterator>(doc, regexp, resr, search);
+			matched = MatchOnLines<ByteIterator>(doc, text, compiled.regexp, resr, search);
 		}
 
 		Sci::Position posMatch = -1;
@@ -3111,7 +3345,7 @@ Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::P
 #ifndef NO_CXX11_REGEX
 	if (flags & SCFIND_CXX11REGEX) {
 			return Cxx11RegexFindText(doc, minPos, maxPos, s,
-			caseSensitive, length, search);
+			caseSensitive, length, search, cxx11Cache);
 	}
 #endif
 
@@ -3119,8 +3353,7 @@ Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::P
 
 	const bool posix = (flags & SCFIND_POSIX) != 0;
 
-	const char *errmsg = search.Compile(s, *length, caseSensitive, posix);
-	if (errmsg) {
+	if (!CompileRE(s, *length, caseSensitive, posix)) {
 		return -1;
 	}
 	// Find a variable in a property file: \$(\([A-Za-z0-9_.]+\))
@@ -3133,7 +3366,21 @@ Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::P
 	const char searchEnd = s[*length - 1];
 	const char searchEndPrev = (*length > 1) ? s[*length - 2] : '\0';
 	const bool searchforLineEnd = (searchEnd == '$') && (searchEndPrev != '\\');
+	const GapText text(doc);
+	// Forwards, lines without the character that all matches start with are skipped
+	const int firstCharacter = (resr.increment == 1) ? search.FirstCharacter() : -1;
 	for (Sci::Line line = resr.lineRangeStart; line != resr.lineRangeBreak; line += resr.increment) {
+		if (firstCharacter >= 0) {
+			const Sci::Position posFirst = text.Find(static_cast<char>(firstCharacter),
+				std::max(doc->LineStart(line), resr.startPos), resr.endPos);
+			if (posFirst < 0) {
+				// As if Execute had failed on the remaining lines
+				search.Clear();
+				break;
+			}
+			if (posFirst >= doc->LineStart(line + 1))
+				line = doc->SciLineFromPosition(posFirst);
+		}
 		Sci::Position startOfLine = doc->LineStart(line);
 		Sci::Position endOfLine = doc->LineEnd(line);
 		if (resr.increment == 1) {
@@ -3160,7 +3407,7 @@ Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::P
 			}
 		}
 
-		const DocumentIndexer di(doc, endOfLine);
+		const DocumentIndexer di(&text, endOfLine);
 		int success = search.Execute(di, startOfLine, endOfLine);
 		if (success) {
 			pos = search.bopat[0];
@@ -3190,9 +3437,35 @@ Sci::Position BuiltinRegex::FindText(Document *doc, Sci::Position minPos, Sci::P
 	return pos;
 }
 
+bool BuiltinRegex::CompileRE(const char *s, Sci::Position length, bool caseSensitive, bool posix) {
+	unsigned char wordChars[256];
+	const size_t lenWordChars = charClass->GetCharsOfClass(CharClassify::ccWord, wordChars);
+	// An empty pattern reuses the previous one so needs no caching
+	if (length && (compiledPattern.length() == static_cast<size_t>(length)) &&
+		(compiledCaseSensitive == caseSensitive) && (compiledPosix == posix) &&
+		(memcmp(compiledPattern.c_str(), s, length) == 0) &&
+		(compiledWordChars.length() == lenWordChars) &&
+		(memcmp(compiledWordChars.c_str(), wordChars, lenWordChars) == 0)) {
+		return true;
+	}
+	const char *errmsg = search.Compile(s, length, caseSensitive, posix);
+	if (errmsg) {
+		compiledPattern.clear();
+		return false;
+	}
+	if (length) {
+		compiledPattern.assign(s, length);
+		compiledCaseSensitive = caseSensitive;
+		compiledPosix = posix;
+		compiledWordChars.assign(wordChars, wordChars + lenWordChars);
+	}
+	return true;
+}
+
 const char *BuiltinRegex::SubstituteByPosition(Document *doc, const char *text, Sci::Position *length) {
 	substituted.clear();
-	const DocumentIndexer di(doc, doc->Length());
+	const GapText docText(doc);
+	const DocumentIndexer di(&docText, doc->Length());
 	search.GrabMatches(di);
 	for (Sci::Position j = 0; j < *length; j++) {
 		if (text[j] == '\\') {
@@ -349,6 +349,9 @@ public:
 	bool CanUndo() const { return cb.CanUndo(); }
 	bool CanRedo() const { return cb.CanRedo(); }
 	void DeleteUndoHistory() { cb.DeleteUndoHistory(); }
+	void SetUndoMemoryLimit(size_t limit) { cb.SetUndoMemoryLimit(limit); }
+	size_t GetUndoMemoryLimit() const { return cb.GetUndoMemoryLimit(); }
+	size_t UndoMemoryUsage() const { return cb.UndoMemoryUsage(); }
 	bool SetUndoCollection(bool collectUndo) {
 		return cb.SetUndoCollection(collectUndo);
 	}
@@ -425,6 +428,15 @@ public:
 	Sci::Position NextWordEnd(Sci::Position pos, int delta) const;
 	Sci_Position SCI_METHOD Length() const override { return cb.Length(); }
 	void Allocate(Sci::Position newSize) { cb.Allocate(newSize); }
+	void SetExternalText(const char *text, Sci::Position length, void (*release)(void *), void *releaseData) {
+		cb.SetExternalText(text, length, release, releaseData);
+		decorations->InsertSpace(0, length);
+	}
+	bool HasExternalText() const noexcept { return cb.HasExternalText(); }
+	void ShareText(Document &clone) {
+		cb.ShareText(clone.cb);
+		clone.decorations->InsertSpace(0, clone.Length());
+	}
 
 	CharacterExtracted ExtractCharacter(Sci::Position position) const noexcept;
 
@@ -458,6 +470,7 @@ public:
 	void IncrementStyleClock() noexcept;
 	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override;
 	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void DecorationFillRanges(const Sci::Position *ranges, size_t count, int value);
 	LexInterface *GetLexInterface() const;
 	void SetLexInterface(LexInterface *pLexInterface);
 
@@ -562,7 +575,7 @@ public:
 		position(act.position),
 		length(act.lenData),
 		linesAdded(linesAdded_),
-		text(act.data.get()),
+		text(act.data),
 		line(0),
 		foldLevelNow(0),
 		foldLevelPrev(0),
@@ -17,6 +17,7 @@
 #include <map>
 #include <algorithm>
 #include <memory>
+#include <mutex>
 
 #include "Platform.h"
 
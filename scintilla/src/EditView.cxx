@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <chrono>
 
 #include "Platform.h"
@@ -70,6 +71,56 @@ PrintParameters::PrintParameters() noexcept {
 	wrapState = eWrapWord;
 }
 
+RenderedLine::RenderedLine() noexcept : lineDoc(-1), lineVisible(-1), subLine(0), posStart(0), posEnd(0), xOffset(0),
+	containsCaret(false), caretActive(false), primarySelection(false), expanded(false), braces{ Sci::invalidPosition, Sci::invalidPosition },
+	bracesMatchStyle(0), hoverIndicatorPos(Sci::invalidPosition), hotspot(Sci::invalidPosition), xHighlightGuide(0),
+	hideSelection(false) {
+}
+
+RenderedLine::RenderedLine(const EditModel &model, const LineLayout *ll, Sci::Line lineDoc_, Sci::Line lineVisible_, int subLine_,
+	Range rangeLine, int xHighlight, bool hideSelection_) :
+	lineDoc(lineDoc_), lineVisible(lineVisible_), subLine(subLine_),
+	posStart(rangeLine.start + ll->LineStart(subLine_)), posEnd(rangeLine.start + ll->LineStart(subLine_ + 1)),
+	xOffset(model.xOffset), containsCaret(ll->containsCaret), caretActive(model.caret.active),
+	primarySelection(model.primarySelection), expanded(model.pcs->GetExpanded(lineDoc_)),
+	braces{ Sci::invalidPosition, Sci::invalidPosition }, bracesMatchStyle(0), hoverIndicatorPos(Sci::invalidPosition),
+	hotspot(Sci::invalidPosition), xHighlightGuide(0), hideSelection(hideSelection_) {
+	// Only state within the line matters so changes elsewhere do not discard this line
+	for (int brace = 0; brace < 2; brace++) {
+		if (rangeLine.ContainsCharacter(model.braces[brace])) {
+			braces[brace] = model.braces[brace];
+			bracesMatchStyle = model.bracesMatchStyle;
+		}
+	}
+	if (rangeLine.ContainsCharacter(model.hoverIndicatorPos))
+		hoverIndicatorPos = model.hoverIndicatorPos;
+	if (ll->hotspot.Valid() && (ll->hotspot.First() < rangeLine.end) && (ll->hotspot.Last() >= rangeLine.start))
+		hotspot = ll->hotspot;
+	// The guide is highlighted on every line between the braces, not just those containing them
+	if (LineLayout::HighlightsGuide(rangeLine, model.braces))
+		xHighlightGuide = xHighlight;
+}
+
+bool RenderedLine::operator==(const RenderedLine &other) const noexcept {
+	return (lineDoc == other.lineDoc) &&
+		(lineVisible == other.lineVisible) &&
+		(subLine == other.subLine) &&
+		(posStart == other.posStart) &&
+		(posEnd == other.posEnd) &&
+		(xOffset == other.xOffset) &&
+		(containsCaret == other.containsCaret) &&
+		(caretActive == other.caretActive) &&
+		(primarySelection == other.primarySelection) &&
+		(expanded == other.expanded) &&
+		(braces[0] == other.braces[0]) &&
+		(braces[1] == other.braces[1]) &&
+		(bracesMatchStyle == other.bracesMatchStyle) &&
+		(hoverIndicatorPos == other.hoverIndicatorPos) &&
+		(hotspot == other.hotspot) &&
+		(xHighlightGuide == other.xHighlightGuide) &&
+		(hideSelection == other.hideSelection);
+}
+
 namespace Scintilla {
 
 bool ValidStyledText(const ViewStyle &vs, size_t styleOffset, const StyledText &st) {
@@ -261,6 +312,7 @@ void EditView::DropGraphics(bool freeObjects) {
 		pixmapLine.reset();
 		pixmapIndentGuide.reset();
 		pixmapIndentGuideHighlight.reset();
+		pixmapRendered.reset();
 	} else {
 		if (pixmapLine)
 			pixmapLine->Release();
@@ -268,7 +320,10 @@ void EditView::DropGraphics(bool freeObjects) {
 			pixmapIndentGuide->Release();
 		if (pixmapIndentGuideHighlight)
 			pixmapIndentGuideHighlight->Release();
+		if (pixmapRendered)
+			pixmapRendered->Release();
 	}
+	renderedLines.clear();
 }
 
 void EditView::AllocateGraphics(const ViewStyle &vsDraw) {
@@ -278,6 +333,8 @@ void EditView::AllocateGraphics(const ViewStyle &vsDraw) {
 		pixmapIndentGuide.reset(Surface::Allocate(vsDraw.technology));
 	if (!pixmapIndentGuideHighlight)
 		pixmapIndentGuideHighlight.reset(Surface::Allocate(vsDraw.technology));
+	if (!pixmapRendered)
+		pixmapRendered.reset(Surface::Allocate(vsDraw.technology));
 }
 
 static const char *ControlCharacterString(unsigned char ch) noexcept {
@@ -334,6 +391,22 @@ void EditView::RefreshPixMaps(Surface *surfaceWindow, WindowID wid, const ViewSt
 	}
 }
 
+void EditView::DiscardRendered() noexcept {
+	std::fill(renderedLines.begin(), renderedLines.end(), RenderedLine());
+}
+
+void EditView::DiscardRendered(Sci::Line lineFirst, Sci::Line lineLast) noexcept {
+	// Arguments are display lines
+	const Sci::Line rows = renderedLines.size();
+	if (lineLast - lineFirst + 1 >= rows) {
+		DiscardRendered();
+	} else {
+		for (Sci::Line line = std::max<Sci::Line>(lineFirst, 0); line <= lineLast; line++) {
+			renderedLines[line % rows] = RenderedLine();
+		}
+	}
+}
+
 LineLayout *EditView::RetrieveLineLayout(Sci::Line lineNumber, const EditModel &model) {
 	const Sci::Position posLineStart = model.pdoc->LineStart(lineNumber);
 	const Sci::Position posLineEnd = model.pdoc->LineStart(lineNumber + 1);
@@ -344,12 +417,157 @@ LineLayout *EditView::RetrieveLineLayout(Sci::Line lineNumber, const EditModel &
 		model.LinesOnScreen() + 1, model.pdoc->LinesTotal());
 }
 
+/**
+* Determine the x position at which each character from the start to the end of
+* @a range starts, continuing from the position of the start of @a range.
+* Returns whether the last segment measured is in italics.
+*/
+bool EditView::LayoutSegments(const EditModel &model, Sci::Line line, Surface *surface, const ViewStyle &vstyle,
+	LineLayout *ll, Range range, Sci::Position posLineStart, bool multiThreaded) {
+	bool lastSegItalics = false;
+
+	BreakFinder bfLayout(ll, nullptr, range, posLineStart, 0, false, model.pdoc, &model.reprs, nullptr);
+	while (bfLayout.More()) {
+
+		const TextSegment ts = bfLayout.Next();
+
+		std::fill(&ll->positions[ts.start + 1], &ll->positions[ts.end() + 1], 0.0f);
+		if (vstyle.styles[ll->styles[ts.start]].visible) {
+			if (ts.representation) {
+				XYPOSITION representationWidth = vstyle.controlCharWidth;
+				if (ll->chars[ts.start] == '\t') {
+					// Tab is a special case of representation, taking a variable amount of space
+					const XYPOSITION x = ll->positions[ts.start];
+					representationWidth = NextTabstopPos(line, x, vstyle.tabWidth) - ll->positions[ts.start];
+				} else {
+					if (representationWidth <= 0.0) {
+						XYPOSITION positionsRepr[256];	// Should expand when needed
+						posCache.MeasureWidths(surface, vstyle, STYLE_CONTROLCHAR, ts.representation->stringRep.c_str(),
+							static_cast<unsigned int>(ts.representation->stringRep.length()), positionsRepr, model.pdoc, multiThreaded);
+						representationWidth = positionsRepr[ts.representation->stringRep.length() - 1] + vstyle.ctrlCharPadding;
+					}
+				}
+				for (int ii = 0; ii < ts.length; ii++)
+					ll->positions[ts.start + 1 + ii] = representationWidth;
+			} else {
+				if ((ts.length == 1) && (' ' == ll->chars[ts.start])) {
+					// Over half the segments are single characters and of these about half are space characters.
+					ll->positions[ts.start + 1] = vstyle.styles[ll->styles[ts.start]].spaceWidth;
+				} else {
+					posCache.MeasureWidths(surface, vstyle, ll->styles[ts.start], &ll->chars[ts.start],
+						ts.length, &ll->positions[ts.start + 1], model.pdoc, multiThreaded);
+				}
+			}
+			lastSegItalics = (!ts.representation) && ((ll->chars[ts.end() - 1] != ' ') && vstyle.styles[ll->styles[ts.start]].italic);
+		}
+
+		for (Sci::Position posToIncrease = ts.start + 1; posToIncrease <= ts.end(); posToIncrease++) {
+			ll->positions[posToIncrease] += ll->positions[ts.start];
+		}
+	}
+	return lastSegItalics;
+}
+
+/**
+* Lay out a long line that has changed since it was laid out by only measuring the
+* part that changed: positions before the change are kept and those after it are
+* moved by the change in width. Returns false when the whole line has to be laid out.
+*/
+bool EditView::LayoutChangedLongLine(const EditModel &model, Sci::Line line, Surface *surface, const ViewStyle &vstyle,
+	LineLayout *ll, bool multiThreaded) {
+	const Sci::Position posLineStart = model.pdoc->LineStart(line);
+	const int lineLength = static_cast<int>(model.pdoc->LineStart(line + 1) - posLineStart);
+	const int numCharsBeforeEOL = static_cast<int>(model.pdoc->LineEnd(line) - posLineStart);
+	const int numCharsInLine = (vstyle.viewEOL) ? lineLength : numCharsBeforeEOL;
+	const int numCharsInLineOld = ll->numCharsInLine;
+	if ((numCharsInLine < LineLayout::lengthLongLine) || (numCharsInLineOld < LineLayout::lengthLongLine) ||
+		(lineLength > ll->maxLineLength) || vstyle.someStylesForceCase) {
+		return false;
+	}
+
+	std::vector<char> chars(lineLength + 1);
+	std::vector<unsigned char> styles(lineLength + 1);
+	model.pdoc->GetCharRange(chars.data(), posLineStart, lineLength);
+	model.pdoc->GetStyleRange(styles.data(), posLineStart, lineLength);
+	const unsigned char styleByteLast = (lineLength > 0) ? styles[lineLength - 1] : 0;
+	chars[numCharsInLine] = 0;
+	styles[numCharsInLine] = styleByteLast;
+
+	// Find the changed part as the range between the common start and end
+	const int lengthCommon = std::min(numCharsInLine, numCharsInLineOld);
+	int start = 0;
+	while ((start < lengthCommon) && (chars[start] == ll->chars[start]) && (styles[start] == ll->styles[start])) {
+		start++;
+	}
+	// The position of the old end of the line may include space for italics
+	start = std::min(start, numCharsInLineOld - 1);
+	int lengthEnd = 0;
+	while ((lengthEnd < lengthCommon - start) &&
+		(chars[numCharsInLine - 1 - lengthEnd] == ll->chars[numCharsInLineOld - 1 - lengthEnd]) &&
+		(styles[numCharsInLine - 1 - lengthEnd] == ll->styles[numCharsInLineOld - 1 - lengthEnd])) {
+		lengthEnd++;
+	}
+	int end = numCharsInLine - lengthEnd;
+
+	// Measure whole words around the change as they may be shaped together
+	// and keep tabs after the change at their tab stops.
+	const int startLimit = std::max(start - BreakFinder::lengthEachSubdivision, 0);
+	while ((start > startLimit) && !IsSpaceOrTab(chars[start - 1]) && (styles[start] == styles[start - 1])) {
+		start--;
+	}
+	start = static_cast<int>(model.pdoc->MovePositionOutsideChar(posLineStart + start, -1) - posLineStart);
+	const int endLimit = std::min(end + BreakFinder::lengthEachSubdivision, numCharsInLine);
+	while ((end > 0) && (end < endLimit) && !IsSpaceOrTab(chars[end]) && (styles[end] == styles[end - 1])) {
+		end++;
+	}
+	end = static_cast<int>(model.pdoc->MovePositionOutsideChar(posLineStart + end, 1) - posLineStart);
+	if (memchr(&chars[end], '\t', numCharsInLine - end)) {
+		end = numCharsInLine;
+	}
+
+	// Move the positions after the change to their new characters then measure the change
+	const int lengthChange = numCharsInLine - numCharsInLineOld;
+	const XYPOSITION xEndOld = ll->positions[end - lengthChange];
+	if (lengthChange != 0) {
+		memmove(&ll->positions[end + 1], &ll->positions[end - lengthChange + 1],
+			(numCharsInLine - end) * sizeof(XYPOSITION));
+	}
+	memcpy(ll->chars.get(), chars.data(), lineLength + 1);
+	memcpy(ll->styles.get(), styles.data(), lineLength + 1);
+	const bool lastSegItalics = LayoutSegments(model, line, surface, vstyle, ll, Range(start, end), posLineStart, multiThreaded);
+	if (end < numCharsInLine) {
+		const XYPOSITION xMove = ll->positions[end] - xEndOld;
+		for (int i = end + 1; i <= numCharsInLine; i++) {
+			ll->positions[i] += xMove;
+		}
+	} else if (lastSegItalics) {
+		ll->positions[numCharsInLine] += vstyle.lastSegItalicsOffset;
+	}
+
+	ll->widthLine = LineLayout::wrapWidthInfinite;
+	ll->lines = 1;
+	ll->xHighlightGuide = 0;
+	if (vstyle.edgeState == EDGE_BACKGROUND) {
+		Sci::Position edgePosition = model.pdoc->FindColumn(line, vstyle.theEdge.column);
+		if (edgePosition >= posLineStart) {
+			edgePosition -= posLineStart;
+		}
+		ll->edgeColumn = static_cast<int>(edgePosition);
+	} else {
+		ll->edgeColumn = -1;
+	}
+	ll->numCharsInLine = numCharsInLine;
+	ll->numCharsBeforeEOL = numCharsBeforeEOL;
+	ll->validity = LineLayout::llPositions;
+	return true;
+}
+
 /**
 * Fill in the LineLayout data for the given line.
 * Copy the given @a line and its styles from the document into local arrays.
 * Also determine the x position at which each character starts.
 */
-void EditView::LayoutLine(const EditModel &model, Sci::Line line, Surface *surface, const ViewStyle &vstyle, LineLayout *ll, int width) {
+void EditView::LayoutLine(const EditModel &model, Sci::Line line, Surface *surface, const ViewStyle &vstyle, LineLayout *ll, int width, bool multiThreaded) {
 	if (!ll)
 		return;
 
@@ -361,7 +579,8 @@ void EditView::LayoutLine(const EditModel &model, Sci::Line line, Surface *surfa
 	if (posLineEnd >(posLineStart + ll->maxLineLength)) {
 		posLineEnd = posLineStart + ll->maxLineLength;
 	}
-	if (ll->validity == LineLayout::llCheckTextAndStyle) {
+	if ((ll->validity == LineLayout::llCheckTextAndStyle) &&
+		!LayoutChangedLongLine(model, line, surface, vstyle, ll, multiThreaded)) {
 		Sci::Position lineLength = posLineEnd - posLineStart;
 		if (!vstyle.viewEOL) {
 			lineLength = model.pdoc->LineEnd(line) - posLineStart;
@@ -456,47 +675,7 @@ void EditView::LayoutLine(const EditModel &model, Sci::Line line, Surface *surfa
 		// Layout the line, determining the position of each character,
 		// with an extra element at the end for the end of the line.
 		ll->positions[0] = 0;
-		bool lastSegItalics = false;
-
-		BreakFinder bfLayout(ll, nullptr, Range(0, numCharsInLine), posLineStart, 0, false, model.pdoc, &model.reprs, nullptr);
-		while (bfLayout.More()) {
-
-			const TextSegment ts = bfLayout.Next();
-
-			std::fill(&ll->positions[ts.start + 1], &ll->positions[ts.end() + 1], 0.0f);
-			if (vstyle.styles[ll->styles[ts.start]].visible) {
-				if (ts.representation) {
-					XYPOSITION representationWidth = vstyle.controlCharWidth;
-					if (ll->chars[ts.start] == '\t') {
-						// Tab is a special case of representation, taking a variable amount of space
-						const XYPOSITION x = ll->positions[ts.start];
-						representationWidth = NextTabstopPos(line, x, vstyle.tabWidth) - ll->positions[ts.start];
-					} else {
-						if (representationWidth <= 0.0) {
-							XYPOSITION positionsRepr[256];	// Should expand when needed
-							posCache.MeasureWidths(surface, vstyle, STYLE_CONTROLCHAR, ts.representation->stringRep.c_str(),
-								static_cast<unsigned int>(ts.representation->stringRep.length()), positionsRepr, model.pdoc);
-							representationWidth = positionsRepr[ts.representation->stringRep.length() - 1] + vstyle.ctrlCharPadding;
-						}
-					}
-					for (int ii = 0; ii < ts.length; ii++)
-						ll->positions[ts.start + 1 + ii] = representationWidth;
-				} else {
-					if ((ts.length == 1) && (' ' == ll->chars[ts.start])) {
-						// Over half the segments are single characters and of these about half are space characters.
-						ll->positions[ts.start + 1] = vstyle.styles[ll->styles[ts.start]].spaceWidth;
-					} else {
-						posCache.MeasureWidths(surface, vstyle, ll->styles[ts.start], &ll->chars[ts.start],
-							ts.length, &ll->positions[ts.start + 1], model.pdoc);
-					}
-				}
-				lastSegItalics = (!ts.representation) && ((ll->chars[ts.end() - 1] != ' ') && vstyle.styles[ll->styles[ts.start]].italic);
-			}
-
-			for (Sci::Position posToIncrease = ts.start + 1; posToIncrease <= ts.end(); posToIncrease++) {
-				ll->positions[posToIncrease] += ll->positions[ts.start];
-			}
-		}
+		const bool lastSegItalics = LayoutSegments(model, line, surface, vstyle, ll, Range(0, numCharsInLine), posLineStart, multiThreaded);
 
 		// Small hack to make lines that end with italics not cut off the edge of the last character
 		if (lastSegItalics) {
@@ -1471,6 +1650,10 @@ void EditView::DrawBackground(Surface *surface, const EditModel &model, const Vi
 		PRectangle rcSegment = rcLine;
 		rcSegment.left = ll->positions[ts.start] + xStart - static_cast<XYPOSITION>(subLineStart);
 		rcSegment.right = ll->positions[ts.end()] + xStart - static_cast<XYPOSITION>(subLineStart);
+		if (rcSegment.left > rcLine.right) {
+			// The rest of the line is past the right side of the window
+			break;
+		}
 		// Only try to draw if really visible - enhances performance by not calling environment to
 		// draw strings that are completely past the right side of the window.
 		if (!rcSegment.Empty() && rcSegment.Intersects(rcLine)) {
@@ -1658,6 +1841,10 @@ void EditView::DrawForeground(Surface *surface, const EditModel &model, const Vi
 		PRectangle rcSegment = rcLine;
 		rcSegment.left = ll->positions[ts.start] + xStart - static_cast<XYPOSITION>(subLineStart);
 		rcSegment.right = ll->positions[ts.end()] + xStart - static_cast<XYPOSITION>(subLineStart);
+		if (rcSegment.left > rcLine.right) {
+			// The rest of the line is past the right side of the window
+			break;
+		}
 		// Only try to draw if really visible - enhances performance by not calling environment to
 		// draw strings that are completely past the right side of the window.
 		if (rcSegment.Intersects(rcLine)) {
@@ -2031,6 +2218,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, PRectan
 #endif
 		const bool bracesIgnoreStyle = ((vsDraw.braceHighlightIndicatorSet && (model.bracesMatchStyle == STYLE_BRACELIGHT)) ||
 			(vsDraw.braceBadLightIndicatorSet && (model.bracesMatchStyle == STYLE_BRACEBAD)));
+		const int xHighlightGuide = static_cast<int>(model.highlightGuideColumn * vsDraw.spaceWidth);
 
 		Sci::Line lineDocPrevious = -1;	// Used to avoid laying out one document line multiple times
 		AutoLineLayout ll(llc, nullptr);
@@ -2081,27 +2269,50 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, PRectan
 					const Range rangeLine(model.pdoc->LineStart(lineDoc),
 						model.pdoc->LineStart(lineDoc + 1));
 
-					// Highlight the current braces if any
-					ll->SetBracesHighlight(rangeLine, model.braces, static_cast<char>(model.bracesMatchStyle),
-						static_cast<int>(model.highlightGuideColumn * vsDraw.spaceWidth), bracesIgnoreStyle);
-
-					if (leftTextOverlap && (bufferedDraw || ((phasesDraw < phasesMultiple) && (phase & drawBack)))) {
-						// Clear the left margin
-						PRectangle rcSpacer = rcLine;
-						rcSpacer.right = rcSpacer.left;
-						rcSpacer.left -= 1;
-						surface->FillRectangle(rcSpacer, vsDraw.styles[STYLE_DEFAULT].back);
+					// Reuse the image of this line from an earlier paint if nothing it shows has changed
+					RenderedLine *rendered = nullptr;
+					RenderedLine renderedCurrent;
+					PRectangle rcRendered;
+					if (bufferedDraw && !renderedLines.empty()) {
+						const Sci::Line row = visibleLine % static_cast<Sci::Line>(renderedLines.size());
+						rendered = &renderedLines[row];
+						renderedCurrent = RenderedLine(model, ll, lineDoc, visibleLine, subLine, rangeLine,
+							xHighlightGuide, hideSelection);
+						rcRendered = PRectangle::FromInts(0, static_cast<int>(row) * vsDraw.lineHeight,
+							static_cast<int>(rcClient.Width()), static_cast<int>(row + 1) * vsDraw.lineHeight);
 					}
 
-					DrawLine(surface, model, vsDraw, ll, lineDoc, visibleLine, xStart, rcLine, subLine, phase);
+					if (rendered && (*rendered == renderedCurrent)) {
+						surface->Copy(PRectangle::FromInts(0, 0, static_cast<int>(rcClient.Width()), vsDraw.lineHeight),
+							Point(0, rcRendered.top), *pixmapRendered);
+					} else {
+						// Highlight the current braces if any
+						ll->SetBracesHighlight(rangeLine, model.braces, static_cast<char>(model.bracesMatchStyle),
+							xHighlightGuide, bracesIgnoreStyle);
+
+						if (leftTextOverlap && (bufferedDraw || ((phasesDraw < phasesMultiple) && (phase & drawBack)))) {
+							// Clear the left margin
+							PRectangle rcSpacer = rcLine;
+							rcSpacer.right = rcSpacer.left;
+							rcSpacer.left -= 1;
+							surface->FillRectangle(rcSpacer, vsDraw.styles[STYLE_DEFAULT].back);
+						}
+
+						DrawLine(surface, model, vsDraw, ll, lineDoc, visibleLine, xStart, rcLine, subLine, phase);
 #if defined(TIME_PAINTING)
-					durPaint += ep.Duration(true);
+						durPaint += ep.Duration(true);
 #endif
-					// Restore the previous styles for the brace highlights in case layout is in cache.
-					ll->RestoreBracesHighlight(rangeLine, model.braces, bracesIgnoreStyle);
+						// Restore the previous styles for the brace highlights in case layout is in cache.
+						ll->RestoreBracesHighlight(rangeLine, model.braces, bracesIgnoreStyle);
+
+						if (phase & drawFoldLines) {
+							DrawFoldLines(surface, model, vsDraw, lineDoc, rcLine);
+						}
 
-					if (phase & drawFoldLines) {
-						DrawFoldLines(surface, model, vsDraw, lineDoc, rcLine);
+						if (rendered) {
+							pixmapRendered->Copy(rcRendered, Point(0, 0), *pixmapLine);
+							*rendered = renderedCurrent;
+						}
 					}
 
 					if (phase & drawCarets) {
@@ -2213,10 +2424,36 @@ static ColourDesired InvertedLight(ColourDesired orig) noexcept {
 	return ColourDesired(std::min(r, 0xffu), std::min(g, 0xffu), std::min(b, 0xffu));
 }
 
+namespace {
+
+// Keeps the measurements made while printing apart from those for the screen until
+// printing ends, even when it ends with an exception.
+class PrintingPositionCache {
+	PositionCache &posCache;
+	const bool shared;
+public:
+	explicit PrintingPositionCache(PositionCache &posCache_) noexcept :
+		posCache(posCache_), shared(posCache_.GetShared()) {
+		// Can't use measurements cached for screen
+		posCache.Clear();
+		posCache.SetShared(false);
+	}
+	PrintingPositionCache(const PrintingPositionCache &) = delete;
+	PrintingPositionCache(PrintingPositionCache &&) = delete;
+	PrintingPositionCache &operator=(const PrintingPositionCache &) = delete;
+	PrintingPositionCache &operator=(PrintingPositionCache &&) = delete;
+	~PrintingPositionCache() {
+		// Clear cache so measurements are not used for screen
+		posCache.Clear();
+		posCache.SetShared(shared);
+	}
+};
+
+}
+
 Sci::Position EditView::FormatRange(bool draw, const Sci_RangeToFormat *pfr, Surface *surface, Surface *surfaceMeasure,
 	const EditModel &model, const ViewStyle &vs) {
-	// Can't use measurements cached for screen
-	posCache.Clear();
+	const PrintingPositionCache printingPosCache(posCache);
 
 	ViewStyle vsPrint(vs);
 	vsPrint.technology = SC_TECHNOLOGY_DEFAULT;
@@ -2391,8 +2628,5 @@ Sci::Position EditView::FormatRange(bool draw, const Sci_RangeToFormat *pfr, Sur
 		++lineDoc;
 	}
 
-	// Clear cache so measurements are not used for screen
-	posCache.Clear();
-
 	return nPrintPos;
 }
@@ -44,6 +44,33 @@ typedef void (*DrawTabArrowFn)(Surface *surface, PRectangle rcTab, int ymid);
 
 class LineTabstops;
 
+/**
+* Identifies what was painted into a row of EditView::pixmapRendered: the display line along with
+* the state, apart from the document and view style, which can change without discarding the row.
+*/
+struct RenderedLine {
+	Sci::Line lineDoc;
+	Sci::Line lineVisible;
+	int subLine;
+	Sci::Position posStart;
+	Sci::Position posEnd;
+	int xOffset;
+	bool containsCaret;
+	bool caretActive;
+	bool primarySelection;
+	bool expanded;
+	Sci::Position braces[2];
+	int bracesMatchStyle;
+	Sci::Position hoverIndicatorPos;
+	Range hotspot;
+	int xHighlightGuide;
+	bool hideSelection;
+	RenderedLine() noexcept;
+	RenderedLine(const EditModel &model, const LineLayout *ll, Sci::Line lineDoc_, Sci::Line lineVisible_, int subLine_,
+		Range rangeLine, int xHighlight, bool hideSelection_);
+	bool operator==(const RenderedLine &other) const noexcept;
+};
+
 /**
 * EditView draws the main text area.
 */
@@ -77,6 +104,11 @@ public:
 	std::unique_ptr<Surface> pixmapLine;
 	std::unique_ptr<Surface> pixmapIndentGuide;
 	std::unique_ptr<Surface> pixmapIndentGuideHighlight;
+	/** In bufferedDraw mode, each painted line without carets is also copied into a row of
+	* pixmapRendered chosen by its display line, so scrolling and caret blinking can copy
+	* unchanged lines back instead of drawing them again. */
+	std::unique_ptr<Surface> pixmapRendered;
+	std::vector<RenderedLine> renderedLines;
 
 	LineLayoutCache llc;
 	PositionCache posCache;
@@ -111,10 +143,16 @@ public:
 	void DropGraphics(bool freeObjects);
 	void AllocateGraphics(const ViewStyle &vsDraw);
 	void RefreshPixMaps(Surface *surfaceWindow, WindowID wid, const ViewStyle &vsDraw);
+	void DiscardRendered() noexcept;
+	void DiscardRendered(Sci::Line lineFirst, Sci::Line lineLast) noexcept;
 
 	LineLayout *RetrieveLineLayout(Sci::Line lineNumber, const EditModel &model);
+	bool LayoutSegments(const EditModel &model, Sci::Line line, Surface *surface, const ViewStyle &vstyle,
+		LineLayout *ll, Range range, Sci::Position posLineStart, bool multiThreaded);
+	bool LayoutChangedLongLine(const EditModel &model, Sci::Line line, Surface *surface, const ViewStyle &vstyle,
+		LineLayout *ll, bool multiThreaded);
 	void LayoutLine(const EditModel &model, Sci::Line line, Surface *surface, const ViewStyle &vstyle,
-		LineLayout *ll, int width = LineLayout::wrapWidthInfinite);
+		LineLayout *ll, int width = LineLayout::wrapWidthInfinite, bool multiThreaded = false);
 
 	Point LocationFromPosition(Surface *surface, const EditModel &model, SelectionPosition pos, Sci::Line topLine,
 				   const ViewStyle &vs, PointEnd pe);
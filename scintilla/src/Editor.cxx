@@ -20,6 +20,12 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <system_error>
 #include <chrono>
 
 #include "Platform.h"
@@ -100,6 +106,102 @@ Timer::Timer() noexcept :
 Idler::Idler() noexcept :
 		state(false), idlerID(0) {}
 
+namespace Scintilla {
+
+// A fixed set of threads that run jobs for Editor::LayoutLinesThreaded. The threads are
+// started on first use and wait for the next job until the process ends, so wrapping in
+// idle time does not start and join threads every time. All Editors share one set so
+// the number of threads does not grow with the number of Editors.
+class LayoutWorkers {
+	std::mutex mutexRun;
+	std::mutex mutex;
+	std::condition_variable cvJob;
+	std::condition_variable cvDone;
+	std::vector<std::thread> threads;
+	std::function<void(size_t)> job;
+	size_t jobThreads = 0;
+	unsigned int jobNumber = 0;
+	size_t running = 0;
+	bool stopping = false;
+
+	void Work(size_t index) {
+		unsigned int jobDone = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			cvJob.wait(lock, [&] { return stopping || (jobNumber != jobDone); });
+			if (stopping) {
+				return;
+			}
+			jobDone = jobNumber;
+			if (index < jobThreads) {
+				lock.unlock();
+				job(index);
+				lock.lock();
+				running--;
+				if (running == 0) {
+					cvDone.notify_one();
+				}
+			}
+		}
+	}
+	// Start threads until there are count of them, as far as the system allows.
+	void Start(size_t count) {
+		try {
+			while (threads.size() < count) {
+				threads.emplace_back(&LayoutWorkers::Work, this, threads.size());
+			}
+		} catch (const std::system_error &) {
+			// Continue with the threads that could be started
+		}
+	}
+	LayoutWorkers() noexcept = default;
+public:
+	LayoutWorkers(const LayoutWorkers &) = delete;
+	LayoutWorkers(LayoutWorkers &&) = delete;
+	LayoutWorkers &operator=(const LayoutWorkers &) = delete;
+	LayoutWorkers &operator=(LayoutWorkers &&) = delete;
+	~LayoutWorkers() {
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			stopping = true;
+		}
+		cvJob.notify_all();
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+	}
+	static LayoutWorkers &Shared() {
+		static LayoutWorkers workers;
+		return workers;
+	}
+	// Run job_ on up to count threads, passing the index of the thread, and jobCaller on the
+	// calling thread, returning when all are finished. Returns false without running either
+	// when no thread could be started. Editors on different threads take turns.
+	// The jobs must not throw.
+	bool Run(size_t count, const std::function<void(size_t)> &job_, const std::function<void()> &jobCaller) {
+		std::lock_guard<std::mutex> guardRun(mutexRun);
+		Start(count);
+		if (threads.empty()) {
+			return false;
+		}
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			job = job_;
+			jobThreads = std::min(count, threads.size());
+			running = jobThreads;
+			jobNumber++;
+		}
+		cvJob.notify_all();
+		jobCaller();
+		std::unique_lock<std::mutex> lock(mutex);
+		cvDone.wait(lock, [&] { return running == 0; });
+		job = nullptr;
+		return true;
+	}
+};
+
+}
+
 static bool IsAllSpacesOrTabs(const char *s, unsigned int len) noexcept {
 	for (unsigned int i = 0; i < len; i++) {
 		// This is safe because IsSpaceOrTab() will return false for null terminators
@@ -183,6 +285,7 @@ Editor::Editor() : durationWrapOneLine(0.00001, 0.000001, 0.0001) {
 	paintAbandonedByStyling = false;
 	paintingAllText = false;
 	willRedrawAll = false;
+	batchingEdits = false;
 	idleStyling = SC_IDLESTYLING_NONE;
 	needIdleStyling = false;
 
@@ -266,6 +369,7 @@ void Editor::SetRepresentations() {
 void Editor::DropGraphics(bool freeObjects) {
 	marginView.DropGraphics(freeObjects);
 	view.DropGraphics(freeObjects);
+	surfacesWrap.clear();
 }
 
 void Editor::AllocateGraphics() {
@@ -465,7 +569,16 @@ bool Editor::AbandonPaint() {
 
 void Editor::RedrawRect(PRectangle rc) {
 	//Platform::DebugPrintf("Redraw %0d,%0d - %0d,%0d\n", rc.left, rc.top, rc.right, rc.bottom);
+	if (rc.bottom > rc.top) {
+		const Sci::Line lineFirst = TopLineOfMain() + static_cast<Sci::Line>(std::floor(rc.top / vs.lineHeight));
+		const Sci::Line lineLast = TopLineOfMain() + static_cast<Sci::Line>(std::floor((rc.bottom - 1) / vs.lineHeight));
+		view.DiscardRendered(lineFirst, lineLast);
+	}
+	RepaintRect(rc);
+}
 
+// Repaint without discarding images of lines as their contents have not changed.
+void Editor::RepaintRect(PRectangle rc) {
 	// Clip the redraw rectangle into the client area
 	const PRectangle rcClient = GetClientRectangle();
 	if (rc.top < rcClient.top)
@@ -488,6 +601,11 @@ void Editor::DiscardOverdraw() {
 
 void Editor::Redraw() {
 	//Platform::DebugPrintf("Redraw all\n");
+	view.DiscardRendered();
+	Repaint();
+}
+
+void Editor::Repaint() {
 	const PRectangle rcClient = GetClientRectangle();
 	wMain.InvalidateRectangle(rcClient);
 	if (wMargin.GetID())
@@ -535,6 +653,8 @@ void Editor::RedrawSelMargin(Sci::Line line, bool allAfter) {
 		const Point ptOrigin = GetVisibleOriginInMain();
 		rcMarkers.Move(-ptOrigin.x, -ptOrigin.y);
 		wMargin.InvalidateRectangle(rcMarkers);
+	} else if (markersInText) {
+		RedrawRect(rcMarkers);
 	} else {
 		wMain.InvalidateRectangle(rcMarkers);
 	}
@@ -560,7 +680,14 @@ PRectangle Editor::RectangleFromRange(Range r, int overlap) {
 }
 
 void Editor::InvalidateRange(Sci::Position start, Sci::Position end) {
-	RedrawRect(RectangleFromRange(Range(start, end), view.LinesOverlap() ? vs.lineOverlap : 0));
+	const Range range(start, end);
+	view.DiscardRendered(pcs->DisplayFromDoc(pdoc->SciLineFromPosition(range.First())),
+		pcs->DisplayLastFromDoc(pdoc->SciLineFromPosition(range.Last())));
+	RepaintRect(RectangleFromRange(range, view.LinesOverlap() ? vs.lineOverlap : 0));
+}
+
+void Editor::RepaintRange(Sci::Position start, Sci::Position end) {
+	RepaintRect(RectangleFromRange(Range(start, end), view.LinesOverlap() ? vs.lineOverlap : 0));
 }
 
 Sci::Position Editor::CurrentPosition() const {
@@ -965,7 +1092,7 @@ void Editor::ScrollTo(Sci::Line line, bool moveThumb) {
 		if (performBlit) {
 			ScrollText(linesToMove);
 		} else {
-			Redraw();
+			Repaint();
 		}
 		willRedrawAll = false;
 #else
@@ -979,7 +1106,7 @@ void Editor::ScrollTo(Sci::Line line, bool moveThumb) {
 
 void Editor::ScrollText(Sci::Line /* linesToMove */) {
 	//Platform::DebugPrintf("Editor::ScrollText %d\n", linesToMove);
-	Redraw();
+	Repaint();
 }
 
 void Editor::HorizontalScrollTo(int xPos) {
@@ -1001,7 +1128,7 @@ void Editor::VerticalCentreCaret() {
 	const Sci::Line newTop = lineDisplay - (LinesOnScreen() / 2);
 	if (topLine != newTop) {
 		SetTopLine(newTop > 0 ? newTop : 0);
-		RedrawRect(GetClientRectangle());
+		RepaintRect(GetClientRectangle());
 	}
 }
 
@@ -1449,11 +1576,12 @@ void Editor::CaretSetPeriod(int period) {
 }
 
 void Editor::InvalidateCaret() {
+	// Carets are drawn over line images so those images stay valid
 	if (posDrag.IsValid()) {
-		InvalidateRange(posDrag.Position(), posDrag.Position() + 1);
+		RepaintRange(posDrag.Position(), posDrag.Position() + 1);
 	} else {
 		for (size_t r=0; r<sel.Count(); r++) {
-			InvalidateRange(sel.Range(r).caret.Position(), sel.Range(r).caret.Position() + 1);
+			RepaintRange(sel.Range(r).caret.Position(), sel.Range(r).caret.Position() + 1);
 		}
 	}
 	UpdateSystemCaret();
@@ -1491,6 +1619,63 @@ bool Editor::WrapOneLine(Surface *surface, Sci::Line lineToWrap) {
 		(vs.annotationVisible ? pdoc->AnnotationLines(lineToWrap) : 0));
 }
 
+// Lay out lines on several threads, each measuring text on its own surface, and return
+// the number of sublines of each line. Returns an empty vector when there are too few
+// lines to be worth it or the platform can not measure text on other threads.
+std::vector<int> Editor::LayoutLinesThreaded(Surface *surface, Sci::Line lineStart, Sci::Line lineEnd) {
+	const Sci::Line minLinesPerThread = 128;
+	const Sci::Line linesPerBlock = 16;
+	const unsigned int maxThreads = 8;
+	const Sci::Line lines = lineEnd - lineStart;
+	const size_t threads = std::min(std::thread::hardware_concurrency(), maxThreads);
+	if ((threads < 2) || (lines / minLinesPerThread < 2)) {
+		return std::vector<int>();
+	}
+	// The calling thread uses surface, the workers need their own
+	while (surfacesWrap.size() < threads - 1) {
+		std::unique_ptr<Surface> surfaceThread(surface->AllocateForThread());
+		if (!surfaceThread) {
+			return std::vector<int>();
+		}
+		surfacesWrap.push_back(std::move(surfaceThread));
+	}
+
+	// The document and view style are only read until all threads are finished.
+	// Each thread takes the next block of lines until there are none left.
+	std::vector<int> linesWrapped(lines);
+	std::atomic<Sci::Line> nextLine(lineStart);
+	std::atomic<bool> failed(false);
+	auto layoutLines = [&](Surface *surfaceThread) {
+		try {
+			LineLayout ll(0);
+			for (;;) {
+				const Sci::Line blockStart = nextLine.fetch_add(linesPerBlock);
+				if (blockStart >= lineEnd) {
+					break;
+				}
+				const Sci::Line blockEnd = std::min(blockStart + linesPerBlock, lineEnd);
+				for (Sci::Line line = blockStart; line < blockEnd; line++) {
+					ll.Resize(static_cast<int>(pdoc->LineStart(line + 1) - pdoc->LineStart(line)));
+					ll.Invalidate(LineLayout::llInvalid);
+					view.LayoutLine(*this, line, surfaceThread, vs, &ll, wrapWidth, true);
+					linesWrapped[line - lineStart] = ll.lines;
+				}
+			}
+		} catch (...) {
+			failed = true;
+		}
+	};
+	const bool ran = LayoutWorkers::Shared().Run(threads - 1, [&](size_t index) {
+		layoutLines(surfacesWrap[index].get());
+	}, [&]() {
+		layoutLines(surface);
+	});
+	if (!ran || failed) {
+		return std::vector<int>();
+	}
+	return linesWrapped;
+}
+
 // Perform  wrapping for a subset of the lines needing wrapping.
 // wsAll: wrap all lines which need wrapping in this single call
 // wsVisible: wrap currently visible lines
@@ -1565,6 +1750,17 @@ bool Editor::WrapLines(WrapScope ws) {
 
 				const Sci::Line linesBeingWrapped = lineToWrapEnd - lineToWrap;
 				ElapsedPeriod epWrapping;
+				const std::vector<int> linesWrapped = LayoutLinesThreaded(surface, lineToWrap, lineToWrapEnd);
+				if (!linesWrapped.empty()) {
+					for (Sci::Line line = lineToWrap; line < lineToWrapEnd; line++) {
+						if (pcs->SetHeight(line, linesWrapped[line - lineToWrap] +
+							(vs.annotationVisible ? pdoc->AnnotationLines(line) : 0))) {
+							wrapOccurred = true;
+						}
+						wrapPending.Wrapped(line);
+					}
+					lineToWrap = lineToWrapEnd;
+				}
 				while (lineToWrap < lineToWrapEnd) {
 					if (WrapOneLine(surface, lineToWrap)) {
 						wrapOccurred = true;
@@ -1708,6 +1904,13 @@ void Editor::RefreshPixMaps(Surface *surfaceWindow) {
 			view.pixmapLine->InitPixMap(static_cast<int>(rcClient.Width()), vs.lineHeight,
 			        surfaceWindow, wMain.GetID());
 		}
+		if (!view.pixmapRendered->Initialised()) {
+			// Enough rows that every line on screen has its own row
+			const int linesRendered = static_cast<int>(rcClient.Height()) / vs.lineHeight + 2;
+			view.pixmapRendered->InitPixMap(static_cast<int>(rcClient.Width()), vs.lineHeight * linesRendered,
+				surfaceWindow, wMain.GetID());
+			view.renderedLines.resize(linesRendered);
+		}
 		if (!marginView.pixmapSelMargin->Initialised()) {
 			marginView.pixmapSelMargin->InitPixMap(vs.fixedColumnWidth,
 				static_cast<int>(rcClient.Height()), surfaceWindow, wMain.GetID());
@@ -1898,6 +2101,104 @@ void Editor::FilterSelections() {
 	}
 }
 
+/**
+ * Visits the selections to apply an edit to each of them.
+ * When the selections are in order, well separated and not in virtual space, they are visited from
+ * the end of the document back to the start so that each change leaves the selections yet to be
+ * visited in place. The visited selections are then moved once at the end, which gives the same
+ * result as moving every selection after each change but is not quadratic with thousands of carets.
+ * Redrawing is also left until the end.
+ */
+class Editor::SelectionEdits {
+	Editor &editor;
+	std::vector<SelectionRange *> ranges;
+	std::vector<Sci::Position> lengths;
+	Sci::Position positionFirst;
+	Sci::Line linesTotal;
+public:
+	SelectionEdits(Editor &editor_, bool reverseAlways, bool separateLines);
+	// Deleted so SelectionEdits objects can not be copied.
+	SelectionEdits(const SelectionEdits &) = delete;
+	SelectionEdits(SelectionEdits &&) = delete;
+	void operator=(const SelectionEdits &) = delete;
+	void operator=(SelectionEdits &&) = delete;
+	~SelectionEdits();
+	size_t Count() const noexcept {
+		return ranges.size();
+	}
+	// Call before editing each selection in turn.
+	SelectionRange &Begin(size_t index) {
+		lengths.push_back(editor.pdoc->Length());
+		return *ranges[index];
+	}
+};
+
+Editor::SelectionEdits::SelectionEdits(Editor &editor_, bool reverseAlways, bool separateLines) :
+	editor(editor_), positionFirst(0), linesTotal(editor_.pdoc->LinesTotal()) {
+	for (size_t r = 0; r < editor.sel.Count(); r++) {
+		ranges.push_back(&editor.sel.Range(r));
+	}
+	std::vector<SelectionRange *> sorted(ranges);
+	// Order selections by position in document.
+	std::sort(sorted.begin(), sorted.end(),
+		[](const SelectionRange *a, const SelectionRange *b) {return *a < *b;});
+	// Overtyping deletes a character after each caret which may reach into the next selection
+	bool batch = (sorted.size() > 1) && !editor.pdoc->IsReadOnly() && !editor.inOverstrike;
+	for (size_t r = 0; batch && (r < sorted.size()); r++) {
+		const SelectionRange &range = *sorted[r];
+		if (range.caret.VirtualSpace() || range.anchor.VirtualSpace()) {
+			batch = false;
+		} else if (r > 0) {
+			// A change for one selection must not reach the next as that may clamp it
+			Sci::Position positionChange = range.Start().Position();
+			if (separateLines) {
+				// May change from the start of its line or, at a line start, join the line before
+				const Sci::Line line = editor.pdoc->SciLineFromPosition(positionChange);
+				const Sci::Position lineStart = editor.pdoc->LineStart(line);
+				positionChange = ((positionChange == lineStart) && (line > 0)) ?
+					editor.pdoc->LineStart(line - 1) : lineStart;
+			}
+			batch = positionChange > sorted[r - 1]->End().Position();
+		}
+	}
+	if (batch || reverseAlways) {
+		ranges.assign(sorted.rbegin(), sorted.rend());
+	}
+	if (batch) {
+		positionFirst = sorted.front()->Start().Position();
+		editor.batchingEdits = true;
+	}
+}
+
+Editor::SelectionEdits::~SelectionEdits() {
+	if (!editor.batchingEdits)
+		return;
+	editor.batchingEdits = false;
+	lengths.push_back(editor.pdoc->Length());
+	// Each visited selection moves by the changes made to the selections visited after it.
+	Sci::Position moved = 0;
+	for (size_t r = lengths.size() - 1; r-- > 0;) {
+		ranges[r]->caret.Add(moved);
+		ranges[r]->anchor.Add(moved);
+		moved += lengths[r + 1] - lengths[r];
+	}
+	if (lengths.size() > 1) {
+		if (editor.pdoc->LinesTotal() != linesTotal) {
+			editor.SetScrollBars();
+			if (editor.SynchronousStylingToVisible()) {
+				editor.QueueIdleWork(WorkNeeded::workStyle, editor.pdoc->Length());
+			}
+			editor.Redraw();
+		} else {
+			const Sci::Position positionLast = ranges.front()->End().Position();
+			if (editor.SynchronousStylingToVisible()) {
+				editor.QueueIdleWork(WorkNeeded::workStyle, positionLast);
+			}
+			editor.InvalidateRange(positionFirst, positionLast);
+		}
+	}
+}
+
 // AddCharUTF inserts an array of bytes which may or may not be in UTF-8.
 void Editor::AddCharUTF(const char *s, unsigned int len, bool treatAsDBCS) {
 	if (len == 0) {
@@ -1907,25 +2208,18 @@ void Editor::AddCharUTF(const char *s, unsigned int len, bool treatAsDBCS) {
 	{
 		UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty() || inOverstrike);
 
-		// Vector elements point into selection in order to change selection.
-		std::vector<SelectionRange *> selPtrs;
-		for (size_t r = 0; r < sel.Count(); r++) {
-			selPtrs.push_back(&sel.Range(r));
-		}
-		// Order selections by position in document.
-		std::sort(selPtrs.begin(), selPtrs.end(),
-			[](const SelectionRange *a, const SelectionRange *b) {return *a < *b;});
-
 		// Loop in reverse to avoid disturbing positions of selections yet to be processed.
-		for (std::vector<SelectionRange *>::reverse_iterator rit = selPtrs.rbegin();
-			rit != selPtrs.rend(); ++rit) {
-			SelectionRange *currentSel = *rit;
+		SelectionEdits edits(*this, true, false);
+		for (size_t r = 0; r < edits.Count(); r++) {
+			SelectionRange *currentSel = &edits.Begin(r);
 			if (!RangeContainsProtected(currentSel->Start().Position(),
 				currentSel->End().Position())) {
 				Sci::Position positionInsert = currentSel->Start().Position();
 				if (!currentSel->Empty()) {
 					if (currentSel->Length()) {
-						pdoc->DeleteChars(positionInsert, currentSel->Length());
+						if (pdoc->DeleteChars(positionInsert, currentSel->Length()) && batchingEdits) {
+							*currentSel = SelectionRange(positionInsert);
+						}
 						currentSel->ClearVirtualSpace();
 					} else {
 						// Range is all virtual so collapse to start of virtual space
@@ -2031,26 +2325,30 @@ void Editor::InsertPaste(const char *text, Sci::Position len) {
 		}
 	} else {
 		// SC_MULTIPASTE_EACH
-		for (size_t r=0; r<sel.Count(); r++) {
-			if (!RangeContainsProtected(sel.Range(r).Start().Position(),
-				sel.Range(r).End().Position())) {
-				Sci::Position positionInsert = sel.Range(r).Start().Position();
-				if (!sel.Range(r).Empty()) {
-					if (sel.Range(r).Length()) {
-						pdoc->DeleteChars(positionInsert, sel.Range(r).Length());
-						sel.Range(r).ClearVirtualSpace();
+		SelectionEdits edits(*this, false, false);
+		for (size_t r=0; r<edits.Count(); r++) {
+			SelectionRange &range = edits.Begin(r);
+			if (!RangeContainsProtected(range.Start().Position(),
+				range.End().Position())) {
+				Sci::Position positionInsert = range.Start().Position();
+				if (!range.Empty()) {
+					if (range.Length()) {
+						if (pdoc->DeleteChars(positionInsert, range.Length()) && batchingEdits) {
+							range = SelectionRange(positionInsert);
+						}
+						range.ClearVirtualSpace();
 					} else {
 						// Range is all virtual so collapse to start of virtual space
-						sel.Range(r).MinimizeVirtualSpace();
+						range.MinimizeVirtualSpace();
 					}
 				}
-				positionInsert = RealizeVirtualSpace(positionInsert, sel.Range(r).caret.VirtualSpace());
+				positionInsert = RealizeVirtualSpace(positionInsert, range.caret.VirtualSpace());
 				const Sci::Position lengthInserted = pdoc->InsertString(positionInsert, text, len);
 				if (lengthInserted > 0) {
-					sel.Range(r).caret.SetPosition(positionInsert + lengthInserted);
-					sel.Range(r).anchor.SetPosition(positionInsert + lengthInserted);
+					range.caret.SetPosition(positionInsert + lengthInserted);
+					range.anchor.SetPosition(positionInsert + lengthInserted);
 				}
-				sel.Range(r).ClearVirtualSpace();
+				range.ClearVirtualSpace();
 			}
 		}
 	}
@@ -2089,14 +2387,18 @@ void Editor::InsertPasteShape(const char *text, Sci::Position len, PasteShape sh
 void Editor::ClearSelection(bool retainMultipleSelections) {
 	if (!sel.IsRectangular() && !retainMultipleSelections)
 		FilterSelections();
-	UndoGroup ug(pdoc);
-	for (size_t r=0; r<sel.Count(); r++) {
-		if (!sel.Range(r).Empty()) {
-			if (!RangeContainsProtected(sel.Range(r).Start().Position(),
-				sel.Range(r).End().Position())) {
-				pdoc->DeleteChars(sel.Range(r).Start().Position(),
-					sel.Range(r).Length());
-				sel.Range(r) = SelectionRange(sel.Range(r).Start());
+	{
+		UndoGroup ug(pdoc);
+		SelectionEdits edits(*this, false, false);
+		for (size_t r=0; r<edits.Count(); r++) {
+			SelectionRange &range = edits.Begin(r);
+			if (!range.Empty()) {
+				if (!RangeContainsProtected(range.Start().Position(),
+					range.End().Position())) {
+					pdoc->DeleteChars(range.Start().Position(),
+						range.Length());
+					range = SelectionRange(range.Start());
+				}
 			}
 		}
 	}
@@ -2262,33 +2564,42 @@ void Editor::DelCharBack(bool allowLineStartDeletion) {
 		allowLineStartDeletion = false;
 	UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty());
 	if (sel.Empty()) {
-		for (size_t r=0; r<sel.Count(); r++) {
-			if (!RangeContainsProtected(sel.Range(r).caret.Position() - 1, sel.Range(r).caret.Position())) {
-				if (sel.Range(r).caret.VirtualSpace()) {
-					sel.Range(r).caret.SetVirtualSpace(sel.Range(r).caret.VirtualSpace() - 1);
-					sel.Range(r).anchor.SetVirtualSpace(sel.Range(r).caret.VirtualSpace());
-				} else {
-					const Sci::Line lineCurrentPos =
-						pdoc->SciLineFromPosition(sel.Range(r).caret.Position());
-					if (allowLineStartDeletion || (pdoc->LineStart(lineCurrentPos) != sel.Range(r).caret.Position())) {
-						if (pdoc->GetColumn(sel.Range(r).caret.Position()) <= pdoc->GetLineIndentation(lineCurrentPos) &&
-								pdoc->GetColumn(sel.Range(r).caret.Position()) > 0 && pdoc->backspaceUnindents) {
-							UndoGroup ugInner(pdoc, !ug.Needed());
-							const int indentation = pdoc->GetLineIndentation(lineCurrentPos);
-							const int indentationStep = pdoc->IndentSize();
-							int indentationChange = indentation % indentationStep;
-							if (indentationChange == 0)
-								indentationChange = indentationStep;
-							const Sci::Position posSelect = pdoc->SetLineIndentation(lineCurrentPos, indentation - indentationChange);
-							// SetEmptySelection
-							sel.Range(r) = SelectionRange(posSelect);
-						} else {
-							pdoc->DelCharBack(sel.Range(r).caret.Position());
+		{
+			// Unindenting changes the start of the line so only batch carets on separate lines
+			SelectionEdits edits(*this, false, true);
+			for (size_t r=0; r<edits.Count(); r++) {
+				SelectionRange &range = edits.Begin(r);
+				if (!RangeContainsProtected(range.caret.Position() - 1, range.caret.Position())) {
+					if (range.caret.VirtualSpace()) {
+						range.caret.SetVirtualSpace(range.caret.VirtualSpace() - 1);
+						range.anchor.SetVirtualSpace(range.caret.VirtualSpace());
+					} else {
+						const Sci::Line lineCurrentPos =
+							pdoc->SciLineFromPosition(range.caret.Position());
+						if (allowLineStartDeletion || (pdoc->LineStart(lineCurrentPos) != range.caret.Position())) {
+							if (pdoc->GetColumn(range.caret.Position()) <= pdoc->GetLineIndentation(lineCurrentPos) &&
+									pdoc->GetColumn(range.caret.Position()) > 0 && pdoc->backspaceUnindents) {
+								UndoGroup ugInner(pdoc, !ug.Needed());
+								const int indentation = pdoc->GetLineIndentation(lineCurrentPos);
+								const int indentationStep = pdoc->IndentSize();
+								int indentationChange = indentation % indentationStep;
+								if (indentationChange == 0)
+									indentationChange = indentationStep;
+								const Sci::Position posSelect = pdoc->SetLineIndentation(lineCurrentPos, indentation - indentationChange);
+								// SetEmptySelection
+								range = SelectionRange(posSelect);
+							} else {
+								const Sci::Position lengthBefore = pdoc->Length();
+								pdoc->DelCharBack(range.caret.Position());
+								if (batchingEdits) {
+									range = SelectionRange(range.caret.Position() - (lengthBefore - pdoc->Length()));
+								}
+							}
 						}
 					}
+				} else {
+					range.ClearVirtualSpace();
 				}
-			} else {
-				sel.Range(r).ClearVirtualSpace();
 			}
 		}
 		ThinRectangularRange();
@@ -2555,6 +2866,10 @@ Sci::Position MovePositionForDeletion(Sci::Position position, Sci::Position star
 
 void Editor::NotifyModified(Document *, DocModification mh, void *) {
 	ContainerNeedsUpdate(SC_UPDATE_CONTENT);
+	if (paintState != notPainting) {
+		// Changes made while painting, such as styling, invalidate no lines so may affect any image
+		view.DiscardRendered();
+	}
 	if (paintState == painting) {
 		CheckForChangeOutsidePaint(Range(mh.position, mh.position + mh.length));
 	}
@@ -2598,11 +2913,17 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 	} else {
 		// Move selection and brace highlights
 		if (mh.modificationType & SC_MOD_INSERTTEXT) {
-			sel.MovePositions(true, mh.position, mh.length);
+			if (!batchingEdits)
+				sel.MovePositions(true, mh.position, mh.length);
+			else if (sel.selType == Selection::selRectangle)
+				sel.Rectangular().MoveForInsertDelete(true, mh.position, mh.length);
 			braces[0] = MovePositionForInsertion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForInsertion(braces[1], mh.position, mh.length);
 		} else if (mh.modificationType & SC_MOD_DELETETEXT) {
-			sel.MovePositions(false, mh.position, mh.length);
+			if (!batchingEdits)
+				sel.MovePositions(false, mh.position, mh.length);
+			else if (sel.selType == Selection::selRectangle)
+				sel.Rectangular().MoveForInsertDelete(false, mh.position, mh.length);
 			braces[0] = MovePositionForDeletion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForDeletion(braces[1], mh.position, mh.length);
 		}
@@ -2660,14 +2981,14 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 				}
 			}
 
-			if (paintState == notPainting && !CanDeferToLastStep(mh)) {
+			if (paintState == notPainting && !CanDeferToLastStep(mh) && !batchingEdits) {
 				if (SynchronousStylingToVisible()) {
 					QueueIdleWork(WorkNeeded::workStyle, pdoc->Length());
 				}
 				Redraw();
 			}
 		} else {
-			if (paintState == notPainting && mh.length && !CanEliminate(mh)) {
+			if (paintState == notPainting && mh.length && !CanEliminate(mh) && !batchingEdits) {
 				if (SynchronousStylingToVisible()) {
 					QueueIdleWork(WorkNeeded::workStyle, mh.position + mh.length);
 				}
@@ -2676,7 +2997,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		}
 	}
 
-	if (mh.linesAdded != 0 && !CanDeferToLastStep(mh)) {
+	if (mh.linesAdded != 0 && !CanDeferToLastStep(mh) && !batchingEdits) {
 		SetScrollBars();
 	}
 
@@ -4703,7 +5024,7 @@ void Editor::SetHoverIndicatorPosition(Sci::Position position) {
 		}
 	}
 	if (hoverIndicatorPosPrev != hoverIndicatorPos) {
-		Redraw();
+		Repaint();
 	}
 }
 
@@ -5198,7 +5519,7 @@ void Editor::SetBraceHighlight(Sci::Position pos0, Sci::Position pos1, int match
 		}
 		bracesMatchStyle = matchStyle;
 		if (paintState == notPainting) {
-			Redraw();
+			Repaint();
 		}
 	}
 }
@@ -5451,6 +5772,8 @@ void Editor::EnsureLineVisible(Sci::Line lineDoc, bool enforcePolicy) {
 void Editor::FoldAll(int action) {
 	pdoc->EnsureStyledTo(pdoc->Length());
 	const Sci::Line maxLine = pdoc->LinesTotal();
+	const bool contractEveryLevel = (action & SC_FOLDACTION_CONTRACT_EVERY_LEVEL) != 0;
+	action &= ~SC_FOLDACTION_CONTRACT_EVERY_LEVEL;
 	bool expanding = action == SC_FOLDACTION_EXPAND;
 	if (action == SC_FOLDACTION_TOGGLE) {
 		// Discover current state
@@ -5463,21 +5786,20 @@ void Editor::FoldAll(int action) {
 	}
 	if (expanding) {
 		pcs->SetVisible(0, maxLine-1, true);
-		for (int line = 0; line < maxLine; line++) {
-			const int levelLine = pdoc->GetLevel(line);
-			if (levelLine & SC_FOLDLEVELHEADERFLAG) {
-				SetFoldExpanded(line, true);
-			}
-		}
+		pcs->ExpandAll();
 	} else {
 		for (Sci::Line line = 0; line < maxLine; line++) {
 			const int level = pdoc->GetLevel(line);
-			if ((level & SC_FOLDLEVELHEADERFLAG) &&
-					(SC_FOLDLEVELBASE == LevelNumber(level))) {
-				SetFoldExpanded(line, false);
-				const Sci::Line lineMaxSubord = pdoc->GetLastChild(line, -1);
-				if (lineMaxSubord > line) {
-					pcs->SetVisible(line + 1, lineMaxSubord, false);
+			if (level & SC_FOLDLEVELHEADERFLAG) {
+				// The whole view is redrawn after so no need to redraw each margin change.
+				// Nested headers hide their own children too as their parent may not be a
+				// header at the base level.
+				if ((SC_FOLDLEVELBASE == LevelNumber(level)) || contractEveryLevel) {
+					pcs->SetExpanded(line, false);
+					const Sci::Line lineMaxSubord = pdoc->GetLastChild(line, -1);
+					if (lineMaxSubord > line) {
+						pcs->SetVisible(line + 1, lineMaxSubord, false);
+					}
 				}
 			}
 		}
@@ -5872,6 +6194,16 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->DeleteUndoHistory();
 		return 0;
 
+	case SCI_SETUNDOMEMORYLIMIT:
+		pdoc->SetUndoMemoryLimit(static_cast<size_t>(wParam));
+		break;
+
+	case SCI_GETUNDOMEMORYLIMIT:
+		return pdoc->GetUndoMemoryLimit();
+
+	case SCI_GETUNDOMEMORY:
+		return pdoc->UndoMemoryUsage();
+
 	case SCI_GETFIRSTVISIBLELINE:
 		return topLine;
 
@@ -6673,6 +7005,13 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETLAYOUTCACHE:
 		return view.llc.GetLevel();
 
+	case SCI_SETLAYOUTCACHEMEMORY:
+		view.llc.SetMemoryLimit(wParam);
+		break;
+
+	case SCI_GETLAYOUTCACHEMEMORY:
+		return view.llc.GetMemoryLimit();
+
 	case SCI_SETPOSITIONCACHE:
 		view.posCache.SetSize(wParam);
 		break;
@@ -6680,6 +7019,19 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETPOSITIONCACHE:
 		return view.posCache.GetSize();
 
+	case SCI_SETSHAREDPOSITIONCACHE:
+		PositionCache::SetSharedSize(wParam);
+		break;
+
+	case SCI_GETSHAREDPOSITIONCACHE:
+		return PositionCache::GetSharedSize();
+
+	case SCI_GETPOSITIONCACHEHITS:
+		return static_cast<sptr_t>(PositionCache::Hits());
+
+	case SCI_GETPOSITIONCACHEMISSES:
+		return static_cast<sptr_t>(PositionCache::Misses());
+
 	case SCI_SETSCROLLWIDTH:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int>(scrollWidth))) {
@@ -6780,9 +7132,12 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		return vs.viewIndentationGuides;
 
 	case SCI_SETHIGHLIGHTGUIDE:
-		if ((highlightGuideColumn != static_cast<int>(wParam)) || (wParam > 0)) {
+		if (highlightGuideColumn != static_cast<int>(wParam)) {
 			highlightGuideColumn = static_cast<int>(wParam);
 			Redraw();
+		} else if (wParam > 0) {
+			// The lines highlighted follow the braces which are part of each rendered line's key
+			Repaint();
 		}
 		break;
 
@@ -7449,6 +7804,11 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 			lParam);
 		break;
 
+	case SCI_INDICATORFILLRANGES:
+		pdoc->DecorationFillRanges(static_cast<const Sci::Position *>(PtrFromSPtr(lParam)), wParam,
+			pdoc->decorations->GetCurrentValue());
+		break;
+
 	case SCI_INDICATORALLONFOR:
 		return pdoc->decorations->AllOnFor(static_cast<Sci::Position>(wParam));
 
@@ -224,6 +224,9 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	PRectangle rcPaint;
 	bool paintingAllText;
 	bool willRedrawAll;
+	/** Set while a SelectionEdits applies a change to many selections, so moving the
+	 * selections and redrawing is done once at its end instead of for each change. */
+	bool batchingEdits;
 	WorkNeeded workNeeded;
 	int idleStyling;
 	bool needIdleStyling;
@@ -251,6 +254,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	// Wrapping support
 	WrapPending wrapPending;
 	ActionDuration durationWrapOneLine;
+	/// Surfaces the threads helping to wrap lines measure text on, as those threads are shared
+	std::vector<std::unique_ptr<Surface>> surfacesWrap;
 
 	bool convertPastes;
 
@@ -296,11 +301,14 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	virtual bool AbandonPaint();
 	virtual void RedrawRect(PRectangle rc);
+	void RepaintRect(PRectangle rc);
 	virtual void DiscardOverdraw();
 	virtual void Redraw();
+	void Repaint();
 	void RedrawSelMargin(Sci::Line line=-1, bool allAfter=false);
 	PRectangle RectangleFromRange(Range r, int overlap);
 	void InvalidateRange(Sci::Position start, Sci::Position end);
+	void RepaintRange(Sci::Position start, Sci::Position end);
 
 	bool UserVirtualSpace() const noexcept {
 		return ((virtualSpaceOptions & SCVS_USERACCESSIBLE) != 0);
@@ -371,6 +379,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool Wrapping() const noexcept;
 	void NeedWrapping(Sci::Line docLineStart=0, Sci::Line docLineEnd=WrapPending::lineLarge);
 	bool WrapOneLine(Surface *surface, Sci::Line lineToWrap);
+	std::vector<int> LayoutLinesThreaded(Surface *surface, Sci::Line lineStart, Sci::Line lineEnd);
 	enum class WrapScope {wsAll, wsVisible, wsIdle};
 	bool WrapLines(WrapScope ws);
 	void LinesJoin();
@@ -390,6 +399,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void ChangeSize();
 
 	void FilterSelections();
+	class SelectionEdits;
 	Sci::Position RealizeVirtualSpace(Sci::Position position, Sci::Position virtualSpace);
 	SelectionPosition RealizeVirtualSpace(const SelectionPosition &position);
 	void AddChar(char ch);
@@ -118,6 +118,15 @@ public:
 		stepPartition++;
 	}
 
+	/// Insert length partitions at partition, starting at the ascending positions.
+	void InsertPartitions(T partition, const T *positions, size_t length) {
+		if (stepPartition < partition) {
+			ApplyStep(partition);
+		}
+		body->InsertFromArray(partition, positions, 0, length);
+		stepPartition += static_cast<T>(length);
+	}
+
 	void SetPartitionStartPosition(T partition, T pos) noexcept {
 		ApplyStep(partition+1);
 		if ((partition < 0) || (partition > body->Length())) {
@@ -14,9 +14,13 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <list>
+#include <unordered_map>
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <atomic>
 
 #include "Platform.h"
 
@@ -51,6 +55,7 @@ LineLayout::LineLayout(int maxLineLength_) :
 	lenLineStarts(0),
 	lineNumber(-1),
 	inCache(false),
+	lastUse(0),
 	maxLineLength(-1),
 	numCharsInLine(0),
 	numCharsBeforeEOL(0),
@@ -73,12 +78,20 @@ LineLayout::~LineLayout() {
 
 void LineLayout::Resize(int maxLineLength_) {
 	if (maxLineLength_ > maxLineLength) {
-		Free();
-		chars.reset(new char[maxLineLength_ + 1]);
-		styles.reset(new unsigned char[maxLineLength_ + 1]);
+		std::unique_ptr<char[]> charsNew(new char[maxLineLength_ + 1]);
+		std::unique_ptr<unsigned char[]> stylesNew(new unsigned char[maxLineLength_ + 1]);
 		// Extra position allocated as sometimes the Windows
 		// GetTextExtentExPoint API writes an extra element.
-		positions.reset(new XYPOSITION[maxLineLength_ + 1 + 1]);
+		std::unique_ptr<XYPOSITION[]> positionsNew(new XYPOSITION[maxLineLength_ + 1 + 1]);
+		// Keep the current layout so a long line can be checked against its new text
+		if (maxLineLength >= 0) {
+			std::copy(chars.get(), chars.get() + maxLineLength + 1, charsNew.get());
+			std::copy(styles.get(), styles.get() + maxLineLength + 1, stylesNew.get());
+			std::copy(positions.get(), positions.get() + maxLineLength + 1 + 1, positionsNew.get());
+		}
+		chars = std::move(charsNew);
+		styles = std::move(stylesNew);
+		positions = std::move(positionsNew);
 		maxLineLength = maxLineLength_;
 	}
 }
@@ -88,6 +101,13 @@ void LineLayout::Free() noexcept {
 	styles.reset();
 	positions.reset();
 	lineStarts.reset();
+	lenLineStarts = 0;
+}
+
+size_t LineLayout::MemoryUsage() const noexcept {
+	const size_t length = maxLineLength + 1;
+	return sizeof(LineLayout) + length * 2 + (length + 1) * sizeof(XYPOSITION) +
+		lenLineStarts * sizeof(int);
 }
 
 void LineLayout::Invalidate(validLevel validity_) {
@@ -140,6 +160,12 @@ void LineLayout::SetLineStart(int line, int start) {
 	lineStarts[line] = start;
 }
 
+// Whether the indentation guide is highlighted on a line: one between or containing the braces.
+bool LineLayout::HighlightsGuide(Range rangeLine, const Sci::Position braces[]) noexcept {
+	return (braces[0] >= rangeLine.start && braces[1] <= rangeLine.end) ||
+		(braces[1] >= rangeLine.start && braces[0] <= rangeLine.end);
+}
+
 void LineLayout::SetBracesHighlight(Range rangeLine, const Sci::Position braces[],
                                     char bracesMatchStyle, int xHighlight, bool ignoreStyle) {
 	if (!ignoreStyle && rangeLine.ContainsCharacter(braces[0])) {
@@ -156,8 +182,7 @@ void LineLayout::SetBracesHighlight(Range rangeLine, const Sci::Position braces[
 			styles[braceOffset] = bracesMatchStyle;
 		}
 	}
-	if ((braces[0] >= rangeLine.start && braces[1] <= rangeLine.end) ||
-	        (braces[1] >= rangeLine.start && braces[0] <= rangeLine.end)) {
+	if (HighlightsGuide(rangeLine, braces)) {
 		xHighlightGuide = xHighlight;
 	}
 }
@@ -246,7 +271,8 @@ int LineLayout::EndLineStyle() const {
 
 LineLayoutCache::LineLayoutCache() :
 	level(0),
-	allInvalidated(false), styleClock(-1), useCount(0) {
+	allInvalidated(false), styleClock(-1), useCount(0),
+	clock(0), memoryUsed(0), memoryLimit(64 * 1024 * 1024) {
 	Allocate(0);
 }
 
@@ -276,7 +302,10 @@ void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesI
 	} else {
 		if (lengthForLevel < cache.size()) {
 			for (size_t i = lengthForLevel; i < cache.size(); i++) {
-				cache[i].reset();
+				if (cache[i]) {
+					memoryUsed -= std::min(memoryUsed, cache[i]->MemoryUsage());
+					cache[i].reset();
+				}
 			}
 		}
 		cache.resize(lengthForLevel);
@@ -287,6 +316,31 @@ void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesI
 void LineLayoutCache::Deallocate() noexcept {
 	PLATFORM_ASSERT(useCount == 0);
 	cache.clear();
+	memoryUsed = 0;
+}
+
+// Discard the least recently used layouts, other than the one at keep, until well
+// under the limit so this is not repeated for each further line laid out.
+void LineLayoutCache::Trim(size_t keep) {
+	std::vector<std::pair<size_t, size_t>> uses;	// Last use and position
+	memoryUsed = 0;
+	for (size_t i = 0; i < cache.size(); i++) {
+		if (cache[i]) {
+			memoryUsed += cache[i]->MemoryUsage();
+			if (i != keep) {
+				uses.emplace_back(cache[i]->lastUse, i);
+			}
+		}
+	}
+	std::sort(uses.begin(), uses.end());
+	const size_t memoryTarget = memoryLimit / 4 * 3;
+	for (const std::pair<size_t, size_t> &use : uses) {
+		if (memoryUsed <= memoryTarget) {
+			break;
+		}
+		memoryUsed -= std::min(memoryUsed, cache[use.second]->MemoryUsage());
+		cache[use.second].reset();
+	}
 }
 
 void LineLayoutCache::Invalidate(LineLayout::validLevel validity_) {
@@ -310,6 +364,13 @@ void LineLayoutCache::SetLevel(int level_) noexcept {
 	}
 }
 
+void LineLayoutCache::SetMemoryLimit(size_t memoryLimit_) {
+	memoryLimit = memoryLimit_;
+	if (memoryLimit && (memoryUsed > memoryLimit) && (useCount == 0)) {
+		Trim(cache.size());
+	}
+}
+
 LineLayout *LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci::Line lineCaret, int maxChars, int styleClock_,
                                       Sci::Line linesOnScreen, Sci::Line linesInDoc) {
 	AllocateForLevel(linesOnScreen, linesInDoc);
@@ -335,18 +396,33 @@ LineLayout *LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci::Line lineCaret,
 		PLATFORM_ASSERT(useCount == 0);
 		if (!cache.empty() && (pos < static_cast<int>(cache.size()))) {
 			if (cache[pos]) {
-				if ((cache[pos]->lineNumber != lineNumber) ||
-				        (cache[pos]->maxLineLength < maxChars)) {
+				if (cache[pos]->lineNumber != lineNumber) {
+					memoryUsed -= std::min(memoryUsed, cache[pos]->MemoryUsage());
 					cache[pos].reset();
+				} else if (cache[pos]->maxLineLength < maxChars) {
+					// Grow with some room to spare so typing into a long line keeps its layout
+					memoryUsed -= std::min(memoryUsed, cache[pos]->MemoryUsage());
+					if (maxChars >= LineLayout::lengthLongLine) {
+						cache[pos]->Resize(maxChars + maxChars / 8);
+					} else {
+						cache[pos]->Resize(maxChars);
+					}
+					memoryUsed += cache[pos]->MemoryUsage();
+					cache[pos]->Invalidate(LineLayout::llCheckTextAndStyle);
 				}
 			}
 			if (!cache[pos]) {
 				cache[pos].reset(new LineLayout(maxChars));
+				memoryUsed += cache[pos]->MemoryUsage();
 			}
 			cache[pos]->lineNumber = lineNumber;
 			cache[pos]->inCache = true;
+			cache[pos]->lastUse = ++clock;
 			ret = cache[pos].get();
 			useCount++;
+			if (memoryLimit && (memoryUsed > memoryLimit)) {
+				Trim(static_cast<size_t>(pos));
+			}
 		}
 	}
 
@@ -462,10 +538,15 @@ BreakFinder::BreakFinder(const LineLayout *ll_, const Selection *psel, Range lin
 	// First find the first visible character
 	if (xStart > 0.0f)
 		nextBreak = ll->FindBefore(static_cast<XYPOSITION>(xStart), lineRange);
-	// Now back to a style break
-	while ((nextBreak > lineRange.start) && (ll->styles[nextBreak] == ll->styles[nextBreak - 1])) {
+	// Now back to a style break, or to a character boundary near the first visible
+	// character when inside a very long run
+	const int limitBack = std::max(nextBreak - static_cast<int>(lengthLongRun), static_cast<int>(lineRange.start));
+	while ((nextBreak > limitBack) && (ll->styles[nextBreak] == ll->styles[nextBreak - 1])) {
 		nextBreak--;
 	}
+	if ((nextBreak > lineRange.start) && (ll->styles[nextBreak] == ll->styles[nextBreak - 1])) {
+		nextBreak = static_cast<int>(pdoc->MovePositionOutsideChar(posLineStart + nextBreak, -1) - posLineStart);
+	}
 
 	if (breakForSelection) {
 		const SelectionPosition posStart(posLineStart);
@@ -504,6 +585,10 @@ TextSegment BreakFinder::Next() {
 	if (subBreak == -1) {
 		const int prev = nextBreak;
 		while (nextBreak < lineRange.end) {
+			if ((nextBreak - prev) >= lengthLongRun) {
+				// Subdivide the part found so far instead of scanning to the end of a very long run
+				break;
+			}
 			int charWidth = 1;
 			if (encodingFamily == efUnicode)
 				charWidth = UTF8DrawBytes(reinterpret_cast<unsigned char *>(&ll->chars[nextBreak]),
@@ -637,10 +722,108 @@ void PositionCacheEntry::ResetClock() noexcept {
 	}
 }
 
+namespace {
+
+// Widths of short runs of text shared by every view in the process so a newly
+// opened view does not measure the same identifiers again. Entries are keyed by
+// the font and encoding rather than the style number as style numbers have
+// different meanings in different views. The least recently used entry is
+// discarded when full.
+class SharedPositionCache {
+	struct Entry {
+		std::vector<XYPOSITION> positions;
+		std::list<const std::string *>::iterator use;
+	};
+	std::unordered_map<std::string, Entry> entries;
+	std::list<const std::string *> uses;	// Most recently used first
+	size_t size;
+	std::mutex mutex;
+public:
+	std::atomic<unsigned long long> hits;
+	std::atomic<unsigned long long> misses;
+
+	SharedPositionCache() : size(0x4000), hits(0), misses(0) {
+	}
+
+	static SharedPositionCache &Instance() {
+		static SharedPositionCache instance;
+		return instance;
+	}
+
+	bool Retrieve(const std::string &key, XYPOSITION *positions) {
+		std::lock_guard<std::mutex> guard(mutex);
+		const auto it = entries.find(key);
+		if (it == entries.end()) {
+			return false;
+		}
+		std::copy(it->second.positions.begin(), it->second.positions.end(), positions);
+		uses.splice(uses.begin(), uses, it->second.use);
+		return true;
+	}
+
+	void Set(const std::string &key, const XYPOSITION *positions, unsigned int len) {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (size == 0) {
+			return;
+		}
+		const auto inserted = entries.emplace(key, Entry());
+		Entry &entry = inserted.first->second;
+		entry.positions.assign(positions, positions + len);
+		if (inserted.second) {
+			uses.push_front(&inserted.first->first);
+			entry.use = uses.begin();
+			Trim();
+		} else {
+			uses.splice(uses.begin(), uses, entry.use);
+		}
+	}
+
+	void Trim() {
+		while (entries.size() > size) {
+			entries.erase(*uses.back());
+			uses.pop_back();
+		}
+	}
+
+	void SetSize(size_t size_) {
+		std::lock_guard<std::mutex> guard(mutex);
+		size = size_;
+		Trim();
+	}
+
+	size_t GetSize() {
+		std::lock_guard<std::mutex> guard(mutex);
+		return size;
+	}
+};
+
+// Identifies the font a style measures with, how the surface measures with it and
+// the text measured.
+void SharedKey(std::string &key, Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
+	const char *s, unsigned int len, const Document *pdoc) {
+	const Style &style = vstyle.styles[styleNumber];
+	const int fontAttributes[] = {
+		style.weight, style.italic, style.sizeZoomed, style.characterSet,
+		style.extraFontFlag, vstyle.technology, pdoc->dbcsCodePage
+	};
+	const unsigned long long surfaceTag = surface->MeasurementTag();
+	key.clear();
+	if (style.fontName) {
+		key.append(style.fontName);
+	}
+	key.push_back('\0');
+	key.append(reinterpret_cast<const char *>(fontAttributes), sizeof(fontAttributes));
+	key.append(reinterpret_cast<const char *>(&surfaceTag), sizeof(surfaceTag));
+	key.append(s, len);
+}
+
+}
+
 PositionCache::PositionCache() {
 	clock = 1;
 	pces.resize(0x400);
 	allClear = true;
+	shared = true;
 }
 
 PositionCache::~PositionCache() {
@@ -662,10 +845,40 @@ void PositionCache::SetSize(size_t size_) {
 	pces.resize(size_);
 }
 
+void PositionCache::SetShared(bool shared_) noexcept {
+	shared = shared_;
+}
+
+bool PositionCache::GetShared() const noexcept {
+	return shared;
+}
+
+void PositionCache::SetSharedSize(size_t size_) {
+	SharedPositionCache::Instance().SetSize(size_);
+}
+
+size_t PositionCache::GetSharedSize() {
+	return SharedPositionCache::Instance().GetSize();
+}
+
+unsigned long long PositionCache::Hits() noexcept {
+	return SharedPositionCache::Instance().hits;
+}
+
+unsigned long long PositionCache::Misses() noexcept {
+	return SharedPositionCache::Instance().misses;
+}
+
 void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
-	const char *s, unsigned int len, XYPOSITION *positions, const Document *pdoc) {
+	const char *s, unsigned int len, XYPOSITION *positions, const Document *pdoc, bool needsLocking) {
 
+	// Callers on several threads share the cache entries but measure on their own surfaces
+	std::unique_lock<std::mutex> guard(mutex, std::defer_lock);
+	if (needsLocking) {
+		guard.lock();
+	}
 	allClear = false;
+	SharedPositionCache &sharedCache = SharedPositionCache::Instance();
 	size_t probe = pces.size();	// Out of bounds
 	if ((!pces.empty()) && (len < 30)) {
 		// Only store short strings in the cache so it doesn't churn with
@@ -675,10 +888,12 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 		const unsigned int hashValue = PositionCacheEntry::Hash(styleNumber, s, len);
 		probe = hashValue % pces.size();
 		if (pces[probe].Retrieve(styleNumber, s, len, positions)) {
+			sharedCache.hits++;
 			return;
 		}
 		const unsigned int probe2 = (hashValue * 37) % pces.size();
 		if (pces[probe2].Retrieve(styleNumber, s, len, positions)) {
+			sharedCache.hits++;
 			return;
 		}
 		// Not found. Choose the oldest of the two slots to replace
@@ -686,7 +901,26 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 			probe = probe2;
 		}
 	}
-	if (len > BreakFinder::lengthStartSubdivision) {
+	if (needsLocking) {
+		guard.unlock();
+	}
+	std::string key;
+	bool found = false;
+	if (shared && (len < 30)) {
+		// Another view may have measured the same text in the same font
+		SharedKey(key, surface, vstyle, styleNumber, s, len, pdoc);
+		found = sharedCache.Retrieve(key, positions);
+	}
+	if (len < 30) {
+		if (found) {
+			sharedCache.hits++;
+		} else {
+			sharedCache.misses++;
+		}
+	}
+	if (found) {
+		// Copy into this view's cache below
+	} else if (len > BreakFinder::lengthStartSubdivision) {
 		// Break up into segments
 		unsigned int startSegment = 0;
 		XYPOSITION xStartSegment = 0;
@@ -703,9 +937,15 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 	} else {
 		FontAlias fontStyle = vstyle.styles[styleNumber].font;
 		surface->MeasureWidths(fontStyle, s, len, positions);
+		if (!key.empty()) {
+			sharedCache.Set(key, positions, len);
+		}
 	}
 	if (probe < pces.size()) {
 		// Store into cache
+		if (needsLocking) {
+			guard.lock();
+		}
 		clock++;
 		if (clock > 60000) {
 			// Since there are only 16 bits for the clock, wrap it round and
@@ -54,8 +54,11 @@ private:
 	/// Drawing is only performed for @a maxLineLength characters on each line.
 	Sci::Line lineNumber;
 	bool inCache;
+	size_t lastUse;
 public:
 	enum { wrapWidthInfinite = 0x7ffffff };
+	// Lines at least this long are only measured again where they changed
+	enum { lengthLongLine = 10000 };
 
 	int maxLineLength;
 	int numCharsInLine;
@@ -87,6 +90,7 @@ public:
 	virtual ~LineLayout();
 	void Resize(int maxLineLength_);
 	void Free() noexcept;
+	size_t MemoryUsage() const noexcept;
 	void Invalidate(validLevel validity_);
 	int LineStart(int line) const;
 	enum class Scope { visibleOnly, includeEnd };
@@ -94,6 +98,7 @@ public:
 	Range SubLineRange(int subLine, Scope scope) const;
 	bool InLine(int offset, int line) const;
 	void SetLineStart(int line, int start);
+	static bool HighlightsGuide(Range rangeLine, const Sci::Position braces[]) noexcept;
 	void SetBracesHighlight(Range rangeLine, const Sci::Position braces[],
 		char bracesMatchStyle, int xHighlight, bool ignoreStyle);
 	void RestoreBracesHighlight(Range rangeLine, const Sci::Position braces[], bool ignoreStyle);
@@ -111,8 +116,12 @@ class LineLayoutCache {
 	bool allInvalidated;
 	int styleClock;
 	int useCount;
+	size_t clock;
+	size_t memoryUsed;
+	size_t memoryLimit;
 	void Allocate(size_t length_);
 	void AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesInDoc);
+	void Trim(size_t keep);
 public:
 	LineLayoutCache();
 	// Deleted so LineLayoutCache objects can not be copied.
@@ -131,6 +140,9 @@ public:
 	void Invalidate(LineLayout::validLevel validity_);
 	void SetLevel(int level_) noexcept;
 	int GetLevel() const noexcept { return level; }
+	// Approximate number of bytes of layouts to keep, 0 for no limit
+	void SetMemoryLimit(size_t memoryLimit_);
+	size_t GetMemoryLimit() const noexcept { return memoryLimit; }
 	LineLayout *Retrieve(Sci::Line lineNumber, Sci::Line lineCaret, int maxChars, int styleClock_,
 		Sci::Line linesOnScreen, Sci::Line linesInDoc);
 	void Dispose(LineLayout *ll) noexcept;
@@ -211,6 +223,8 @@ public:
 	enum { lengthStartSubdivision = 300 };
 	// Try to make each subdivided run lengthEachSubdivision or shorter.
 	enum { lengthEachSubdivision = 100 };
+	// Stop looking for the end of a run after lengthLongRun and subdivide what was found.
+	enum { lengthLongRun = 1000 };
 	BreakFinder(const LineLayout *ll_, const Selection *psel, Range lineRange_, Sci::Position posLineStart_,
 		int xStart, bool breakForSelection, const Document *pdoc_, const SpecialRepresentations *preprs_, const ViewStyle *pvsDraw);
 	// Deleted so BreakFinder objects can not be copied.
@@ -227,6 +241,8 @@ class PositionCache {
 	std::vector<PositionCacheEntry> pces;
 	unsigned int clock;
 	bool allClear;
+	bool shared;
+	std::mutex mutex;
 public:
 	PositionCache();
 	// Deleted so PositionCache objects can not be copied.
@@ -238,8 +254,16 @@ public:
 	void Clear() noexcept;
 	void SetSize(size_t size_);
 	size_t GetSize() const noexcept { return pces.size(); }
+	// Whether measurements are exchanged with the cache shared by all views.
+	// Turned off while printing as printer measurements differ from the screen.
+	void SetShared(bool shared_) noexcept;
+	bool GetShared() const noexcept;
+	static void SetSharedSize(size_t size_);
+	static size_t GetSharedSize();
+	static unsigned long long Hits() noexcept;
+	static unsigned long long Misses() noexcept;
 	void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
-		const char *s, unsigned int len, XYPOSITION *positions, const Document *pdoc);
+		const char *s, unsigned int len, XYPOSITION *positions, const Document *pdoc, bool needsLocking=false);
 };
 
 }
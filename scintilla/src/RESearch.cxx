@@ -800,6 +800,19 @@ int RESearch::Execute(const CharacterIndexer &ci, Sci::Position lp, Sci::Positio
 	return 1;
 }
 
+/*
+ * FirstCharacter:
+ *
+ *  The character that every match of the compiled pattern starts
+ *  with, or -1 when a match may start with different characters.
+ *  Lets callers skip text that cannot match without calling Execute.
+ */
+int RESearch::FirstCharacter() const noexcept {
+	if (nfa[0] == CHR)
+		return static_cast<unsigned char>(nfa[1]);
+	return -1;
+}
+
 /*
  * PMatch: internal routine for the hard part
  *
@@ -28,6 +28,7 @@ public:
 	void GrabMatches(const CharacterIndexer &ci);
 	const char *Compile(const char *pattern, Sci::Position length, bool caseSensitive, bool posix);
 	int Execute(const CharacterIndexer &ci, Sci::Position lp, Sci::Position endp);
+	int FirstCharacter() const noexcept;
 
 	enum { MAXTAG=10 };
 	enum { NOTFOUND=-1 };
@@ -179,6 +179,78 @@ FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRange(DISTANCE position, ST
 	}
 }
 
+template <typename DISTANCE, typename STYLE>
+FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRanges(const DISTANCE *ranges, size_t count, STYLE value) {
+	if (count == 0) {
+		return FillResult<DISTANCE>{false, 0, 0};
+	}
+	const DISTANCE first = ranges[0];
+	const FillResult<DISTANCE> result{ true, first, ranges[count * 2 - 1] - first };
+	const DISTANCE length = Length();
+	const DISTANCE runs = starts->Partitions();
+	if (count < static_cast<size_t>(runs) / 16) {
+		// Few ranges over many runs: cheaper to edit the runs in place
+		bool changed = false;
+		for (size_t i = 0; i < count; i++) {
+			changed = FillRange(ranges[i * 2], value, ranges[i * 2 + 1] - ranges[i * 2]).changed || changed;
+		}
+		return changed ? result : FillResult<DISTANCE>{false, first, result.fillLength};
+	}
+
+	std::vector<DISTANCE> runStarts;
+	std::vector<STYLE> runStyles;
+	runStarts.reserve(runs + count * 2);
+	runStyles.reserve(runs + count * 2);
+	// Appends a run, merging it with the previous run when empty or of the same style
+	auto addRun = [&runStarts, &runStyles](DISTANCE position, STYLE style) {
+		if (!runStarts.empty() && (runStarts.back() == position)) {
+			runStarts.pop_back();
+			runStyles.pop_back();
+		}
+		if (runStyles.empty() || (runStyles.back() != style)) {
+			runStarts.push_back(position);
+			runStyles.push_back(style);
+		}
+	};
+	DISTANCE run = 0;
+	for (size_t i = 0; i < count; i++) {
+		const DISTANCE start = ranges[i * 2];
+		const DISTANCE end = ranges[i * 2 + 1];
+		while ((run < runs) && (starts->PositionFromPartition(run) < start)) {
+			addRun(starts->PositionFromPartition(run), styles->ValueAt(run));
+			run++;
+		}
+		addRun(start, value);
+		while ((run < runs) && (starts->PositionFromPartition(run) <= end)) {
+			run++;
+		}
+		if (end < length) {
+			addRun(end, styles->ValueAt(run - 1));
+		}
+	}
+	for (; run < runs; run++) {
+		addRun(starts->PositionFromPartition(run), styles->ValueAt(run));
+	}
+
+	bool changed = static_cast<size_t>(runs) != runStarts.size();
+	for (DISTANCE r = 0; !changed && (r < runs); r++) {
+		changed = (starts->PositionFromPartition(r) != runStarts[r]) || (styles->ValueAt(r) != runStyles[r]);
+	}
+	if (!changed) {
+		return FillResult<DISTANCE>{false, first, result.fillLength};
+	}
+
+	DeleteAll();
+	starts->InsertText(0, length);
+	if (runStarts.size() > 1) {
+		starts->InsertPartitions(1, runStarts.data() + 1, runStarts.size() - 1);
+	}
+	styles->DeleteAll();
+	styles->InsertFromArray(0, runStyles.data(), 0, runStyles.size());
+	styles->InsertValue(styles->Length(), 1, 0);
+	return result;
+}
+
 template <typename DISTANCE, typename STYLE>
 void RunStyles<DISTANCE, STYLE>::SetValueAt(DISTANCE position, STYLE value) {
 	FillRange(position, value, 1);
@@ -47,6 +47,9 @@ public:
 	DISTANCE EndRun(DISTANCE position) const noexcept;
 	// Returns changed=true if some values may have changed
 	FillResult<DISTANCE> FillRange(DISTANCE position, STYLE value, DISTANCE fillLength);
+	// Fills count ranges given as start and end pairs, which must be ascending and not
+	// overlap, by rebuilding the runs in one pass. Returns the extent of all the ranges.
+	FillResult<DISTANCE> FillRanges(const DISTANCE *ranges, size_t count, STYLE value);
 	void SetValueAt(DISTANCE position, STYLE value);
 	void InsertSpace(DISTANCE position, DISTANCE insertLength);
 	void DeleteAll();
@@ -16,6 +16,7 @@
 #include <map>
 #include <algorithm>
 #include <memory>
+#include <mutex>
 
 #include "Platform.h"
 
@@ -240,10 +241,14 @@ void ScintillaBase::AutoCompleteInsert(Sci::Position startPos, Sci::Position rem
 	}
 }
 
-void ScintillaBase::AutoCompleteStart(Sci::Position lenEntered, const char *list) {
+void ScintillaBase::AutoCompleteStart(Sci::Position lenEntered, const char *list, const char *const *items) {
 	//Platform::DebugPrintf("AutoComplete %s\n", list);
 	ct.CallTipCancel();
 
+	if (items) {
+		// A single item is treated like a list without separators
+		list = (items[0] && !items[1]) ? items[0] : nullptr;
+	}
 	if (ac.chooseSingle && (listType == 0)) {
 		if (list && !strchr(list, ac.GetSeparator())) {
 			const char *typeSep = strchr(list, ac.GetTypesep());
@@ -298,7 +303,10 @@ void ScintillaBase::AutoCompleteStart(Sci::Position lenEntered, const char *list
 	ac.lb->SetAverageCharWidth(aveCharWidth);
 	ac.lb->SetDelegate(this);
 
-	ac.SetList(list ? list : "");
+	if (items)
+		ac.SetItems(items);
+	else
+		ac.SetList(list ? list : "");
 
 	// Fiddle the position of the list so it is right next to the target and wide enough for all its strings
 	PRectangle rcList = ac.lb->GetDesiredRect();
@@ -851,6 +859,14 @@ sptr_t ScintillaBase::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lPara
 		AutoCompleteStart(static_cast<Sci::Position>(wParam), ConstCharPtrFromSPtr(lParam));
 		break;
 
+	case SCI_AUTOCSHOWITEMS: {
+			static const char *const noItems[] = { nullptr };
+			const char *const *items = static_cast<const char *const *>(PtrFromSPtr(lParam));
+			listType = 0;
+			AutoCompleteStart(static_cast<Sci::Position>(wParam), nullptr, items ? items : noItems);
+		}
+		break;
+
 	case SCI_AUTOCCANCEL:
 		ac.Cancel();
 		break;
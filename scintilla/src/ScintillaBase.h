@@ -67,7 +67,7 @@ protected:
 	int KeyCommand(unsigned int iMessage) override;
 
 	void AutoCompleteInsert(Sci::Position startPos, Sci::Position removeLen, const char *text, Sci::Position textLen);
-	void AutoCompleteStart(Sci::Position lenEntered, const char *list);
+	void AutoCompleteStart(Sci::Position lenEntered, const char *list, const char *const *items=nullptr);
 	void AutoCompleteCancel();
 	void AutoCompleteMove(int delta);
 	int AutoCompleteGetCurrent() const;
@@ -305,6 +305,28 @@ public:
 		return body.data();
 	}
 
+	/// Hand over the elements, followed by an empty element as for BufferPointer,
+	/// without copying them and leave the buffer empty.
+	std::vector<T> Extract() {
+		BufferPointer();
+		std::vector<T> elements;
+		elements.swap(body);
+		elements.resize(lengthBody + 1);
+		Init();
+		return elements;
+	}
+
+	/// Take over elements, as returned by Extract, holding length elements followed by
+	/// the gap. The buffer must be empty.
+	void Adopt(std::vector<T> &&elements, ptrdiff_t length) {
+		body = std::move(elements);
+		// Extract only shortened the vector so its old gap is still allocated
+		body.resize(body.capacity());
+		lengthBody = length;
+		part1Length = length;
+		gapLength = body.size() - length;
+	}
+
 	/// Return a pointer to a range of elements, first rearranging the buffer if
 	/// needed to make that range contiguous.
 	T *RangePointer(ptrdiff_t position, ptrdiff_t rangeLength) noexcept {
@@ -62,13 +62,17 @@
 
 
 /* Number of editor indicators to draw - limited as this can affect performance */
-#define GEANY_BUILD_ERR_HIGHLIGHT_MAX 50
+#define GEANY_BUILD_ERR_HIGHLIGHT_MAX 5000
 
 
 GeanyBuildInfo build_info = {GEANY_GBG_FT, 0, 0, NULL, GEANY_FILETYPES_NONE, NULL, 0};
 
 static gchar *current_dir_entered = NULL;
 
+/* error lines waiting to get indicators, per document id */
+static GHashTable *pending_error_lines = NULL;
+static guint pending_error_lines_source = 0;
+
 typedef struct RunInfo
 {
 	GPid pid;
@@ -175,8 +179,11 @@ static void process_build_output_line(gchar *msg, gint color);
 static void show_build_commands_dialog(void);
 static void on_build_menu_item(GtkWidget *w, gpointer user_data);
 
+static void clear_pending_error_lines(void);
+
 void build_finalize(void)
 {
+	clear_pending_error_lines();
 	g_free(build_info.dir);
 	g_free(build_info.custom_target);
 
@@ -702,6 +709,7 @@ static void clear_all_errors(void)
 {
 	guint i;
 
+	clear_pending_error_lines();
 	foreach_document(i)
 	{
 		editor_indicator_clear_errors(documents[i]->editor);
@@ -995,6 +1003,67 @@ static void build_run_cmd(GeanyDocument *doc, guint cmdindex)
 }
 
 
+static void clear_pending_error_lines(void)
+{
+	if (pending_error_lines_source != 0)
+	{
+		g_source_remove(pending_error_lines_source);
+		pending_error_lines_source = 0;
+	}
+	if (pending_error_lines != NULL)
+	{
+		g_hash_table_destroy(pending_error_lines);
+		pending_error_lines = NULL;
+	}
+}
+
+
+static gboolean set_pending_error_lines(gpointer user_data)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_hash_table_iter_init(&iter, pending_error_lines);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		GeanyDocument *doc = document_find_by_id(GPOINTER_TO_UINT(key));
+		GArray *lines = value;
+
+		if (doc != NULL)
+			editor_indicator_set_on_lines(doc->editor, GEANY_INDICATOR_ERROR,
+				(const gint *) lines->data, lines->len);
+	}
+	g_hash_table_remove_all(pending_error_lines);
+
+	pending_error_lines_source = 0;
+	return FALSE;
+}
+
+
+/* Queues an error indicator on line of doc. Build output arrives a few lines at a time,
+ * so the indicators are set together from an idle callback rather than one by one. */
+static void add_pending_error_line(GeanyDocument *doc, gint line)
+{
+	gpointer key = GUINT_TO_POINTER(doc->id);
+	GArray *lines;
+
+	if (pending_error_lines == NULL)
+		pending_error_lines = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, (GDestroyNotify) g_array_unref);
+
+	lines = g_hash_table_lookup(pending_error_lines, key);
+	if (lines == NULL)
+	{
+		lines = g_array_new(FALSE, FALSE, sizeof(gint));
+		g_hash_table_insert(pending_error_lines, key, lines);
+	}
+	g_array_append_val(lines, line);
+
+	if (pending_error_lines_source == 0)
+		pending_error_lines_source = g_idle_add(set_pending_error_lines, NULL);
+}
+
+
 static void process_build_output_line(gchar *msg, gint color)
 {
 	gchar *tmp;
@@ -1022,7 +1091,7 @@ static void process_build_output_line(gchar *msg, gint color)
 		{
 			if (line > 0) /* some compilers, like pdflatex report errors on line 0 */
 				line--;   /* so only adjust the line number if it is greater than 0 */
-			editor_indicator_set_on_line(doc->editor, GEANY_INDICATOR_ERROR, line);
+			add_pending_error_line(doc, line);
 		}
 		build_info.message_count++;
 		color = COLOR_RED;	/* error message parsed on the line */
@@ -35,6 +35,7 @@
 #include "encodingsprivate.h"
 #include "filetypes.h"
 #include "main.h"
+#include "sciwrappers.h"
 #include "support.h"
 #include "utils.h"
 #include "ui_utils.h"
@@ -1151,6 +1152,7 @@ void dialogs_show_file_properties(GeanyDocument *doc)
 {
 	GtkWidget *dialog, *label, *image, *check;
 	gchar *file_size, *title, *base_name, *time_changed, *time_modified, *time_accessed, *enctext;
+	gchar *undo_size;
 	gchar *short_name;
 #ifdef HAVE_SYS_TYPES_H
 	GStatBuf st;
@@ -1259,6 +1261,11 @@ void dialogs_show_file_properties(GeanyDocument *doc)
 	label = ui_lookup_widget(dialog, "file_accessed_label");
 	gtk_label_set_text(GTK_LABEL(label), time_accessed);
 
+	label = ui_lookup_widget(dialog, "file_undo_label");
+	undo_size = utils_make_human_readable_str(sci_get_undo_memory(doc->editor->sci), 1, 0);
+	gtk_label_set_text(GTK_LABEL(label), undo_size);
+	g_free(undo_size);
+
 	/* permissions */
 	check = ui_lookup_widget(dialog, "file_perm_owner_r_check");
 	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(check), mode & S_IRUSR);
@@ -64,6 +64,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 
 #ifdef HAVE_SYS_TYPES_H
 # include <sys/types.h>
@@ -71,6 +72,11 @@
 
 #include <stdlib.h>
 
+#ifdef G_OS_UNIX
+# include <signal.h>
+# include <sys/mman.h>
+#endif
+
 /* gstdio.h also includes sys/stat.h */
 #include <glib/gstdio.h>
 
@@ -113,12 +119,15 @@ static void document_undo_clear(GeanyDocument *doc);
 static void document_undo_add_internal(GeanyDocument *doc, guint type, gpointer data);
 static void document_redo_add(GeanyDocument *doc, guint type, gpointer data);
 static gboolean remove_page(guint page_num);
+static GeanyDocument *new_file(const gchar *utf8_filename, GeanyFiletype *ft, const gchar *text,
+	gpointer sci_doc);
 static GtkWidget* document_show_message(GeanyDocument *doc, GtkMessageType msgtype,
 	void (*response_cb)(GtkWidget *info_bar, gint response_id, GeanyDocument *doc),
 	const gchar *btn_1, GtkResponseType response_1,
 	const gchar *btn_2, GtkResponseType response_2,
 	const gchar *btn_3, GtkResponseType response_3,
 	const gchar *extra_text, const gchar *format, ...) G_GNUC_PRINTF(11, 12);
+static void show_mapped_file_message(GeanyDocument *doc);
 
 
 /**
@@ -823,6 +832,25 @@ GeanyDocument *document_new_file_if_non_open(void)
  **/
 GEANY_API_SYMBOL
 GeanyDocument *document_new_file(const gchar *utf8_filename, GeanyFiletype *ft, const gchar *text)
+{
+	return new_file(utf8_filename, ft, text, NULL);
+}
+
+
+/* Replaces the Scintilla document of doc with sci_doc, taking over its reference, and
+ * restores the document settings made by editor_create(). */
+static void set_sci_document(GeanyDocument *doc, gpointer sci_doc)
+{
+	sci_set_document(doc->editor->sci, sci_doc);
+	sci_set_codepage(doc->editor->sci, SC_CP_UTF8);
+	editor_apply_update_prefs(doc->editor);
+}
+
+
+/* Like document_new_file() but shows sci_doc, a Scintilla document, instead of text if it is
+ * not NULL. The new document takes over the reference to sci_doc. */
+static GeanyDocument *new_file(const gchar *utf8_filename, GeanyFiletype *ft, const gchar *text,
+	gpointer sci_doc)
 {
 	GeanyDocument *doc;
 
@@ -838,7 +866,14 @@ GeanyDocument *document_new_file(const gchar *utf8_filename, GeanyFiletype *ft,
 	g_assert(doc != NULL);
 
 	sci_set_undo_collection(doc->editor->sci, FALSE); /* avoid creation of an undo action */
-	if (text)
+	if (sci_doc)
+	{
+		set_sci_document(doc, sci_doc);
+		sci_set_undo_collection(doc->editor->sci, FALSE);
+		/* like text, only copied if any line ending differs */
+		sci_convert_eols(doc->editor->sci, file_prefs.default_eol_character);
+	}
+	else if (text)
 	{
 		GString *template = g_string_new(text);
 		utils_ensure_same_eol_characters(template, file_prefs.default_eol_character);
@@ -921,9 +956,20 @@ typedef struct
 	gboolean	 bom;
 	time_t		 mtime;	/* modification time, read by stat::st_mtime */
 	gboolean	 readonly;
+	gint		 eol_mode;	/* line endings, only set when data is NULL */
+	gboolean	 mapped;	/* whether the text is shown from a memory mapping */
 } FileData;
 
 
+/* files from this size on are streamed into Scintilla by load_text_file_streamed() */
+#define STREAMED_LOAD_MIN_SIZE (1024 * 1024)
+#define STREAMED_LOAD_CHUNK_SIZE (256 * 1024)
+/* files from this size on are shown from a memory mapping by load_text_file_mapped() */
+#define MAPPED_LOAD_MIN_SIZE (64 * 1024 * 1024)
+/* how much of a mapped file is checked for its encoding and line endings */
+#define MAPPED_LOAD_CHECK_SIZE (1024 * 1024)
+
+
 static gboolean get_mtime(const gchar *locale_filename, time_t *time)
 {
 	GError *error = NULL;
@@ -984,6 +1030,7 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 	filedata->enc = NULL;
 	filedata->bom = FALSE;
 	filedata->readonly = FALSE;
+	filedata->mapped = FALSE;
 
 	if (!get_mtime(locale_filename, &filedata->mtime))
 		return FALSE;
@@ -1040,6 +1087,305 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 }
 
 
+/* Streams a UTF-8 file into a new Scintilla document through a loader, detecting the
+ * line endings on the way, so that the file contents are never held in memory besides
+ * the document itself.
+ * Returns the document, or NULL if the file has to be loaded by load_text_file() instead,
+ * e.g. because it is small, needs conversion or contains null bytes. Errors are left
+ * to be reported by load_text_file() as well. */
+static gpointer load_text_file_streamed(const gchar *locale_filename, FileData *filedata,
+	const gchar *forced_enc)
+{
+	GFile *file = g_file_new_for_path(locale_filename);
+	GFileInputStream *stream = g_file_read(file, NULL, NULL);
+	GFileInfo *info = NULL;
+	GeanyLineEndingCounts eol_counts = { 0 };
+	gpointer loader = NULL;
+	gboolean ok = TRUE;
+	gchar *buf;
+	gsize pending = 0;	/* bytes of an incomplete character at the start of buf */
+
+	g_object_unref(file);
+	if (stream)
+	{
+		info = g_file_input_stream_query_info(stream,
+			G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED, NULL, NULL);
+	}
+	if (!info || g_file_info_get_size(info) < STREAMED_LOAD_MIN_SIZE)
+	{
+		if (info)
+			g_object_unref(info);
+		if (stream)
+			g_object_unref(stream);
+		return NULL;
+	}
+
+	/* leave room for a character split between two chunks */
+	buf = g_malloc(STREAMED_LOAD_CHUNK_SIZE + 3);
+	while (ok)
+	{
+		const gchar *start = buf, *end;
+		gsize n, avail;
+
+		if (!g_input_stream_read_all(G_INPUT_STREAM(stream), buf + pending,
+				STREAMED_LOAD_CHUNK_SIZE, &n, NULL, NULL))
+		{
+			ok = FALSE;
+			break;
+		}
+		if (n == 0)
+		{
+			/* a character cut off by the end of the file is invalid */
+			ok = (pending == 0);
+			break;
+		}
+		avail = pending + n;
+
+		if (!loader)
+		{
+			/* the first chunk decides whether the file is read as UTF-8 */
+			if (!encodings_is_utf8_candidate(buf, avail, forced_enc, &filedata->bom))
+			{
+				ok = FALSE;
+				break;
+			}
+			if (filedata->bom)
+				start += 3;
+			loader = sci_loader_new((gsize) g_file_info_get_size(info));
+		}
+
+		/* add the complete characters and keep a possibly incomplete one for the next
+		 * chunk, which can't be longer than 3 bytes. This also rejects null bytes. */
+		if (!g_utf8_validate(start, buf + avail - start, &end) && buf + avail - end > 3)
+			ok = FALSE;
+		else
+		{
+			utils_count_line_endings(&eol_counts, start, end - start);
+			ok = sci_loader_add_data(loader, start, end - start);
+			pending = buf + avail - end;
+			memmove(buf, end, pending);
+		}
+	}
+	g_free(buf);
+	g_object_unref(stream);
+
+	if (!ok || !loader)
+	{
+		if (loader)
+			sci_loader_free(loader);
+		g_object_unref(info);
+		return NULL;
+	}
+
+	{
+		GTimeVal timeval;
+
+		g_file_info_get_modification_time(info, &timeval);
+		filedata->mtime = timeval.tv_sec;
+	}
+	g_object_unref(info);
+
+	filedata->data = NULL;
+	filedata->len = 0;
+	filedata->enc = g_strdup("UTF-8");
+	filedata->readonly = FALSE;
+	filedata->mapped = FALSE;
+	filedata->eol_mode = utils_get_line_endings_from_counts(&eol_counts);
+	return sci_loader_get_document(loader);
+}
+
+
+#ifdef G_OS_UNIX
+/* The mappings of the files shown by load_text_file_mapped(). Reading the text past the end
+ * of a file truncated while it is mapped raises SIGBUS, so on_mapped_file_sigbus() maps zeros
+ * over the rest of the mapping instead. The text then reads as NUL bytes until
+ * document_check_disk_status() sees that the file changed and reloads it. */
+#define MAPPED_FILES_MAX 64
+static struct
+{
+	const gchar *volatile start;
+	volatile gsize len;
+} mapped_files[MAPPED_FILES_MAX];
+static struct sigaction mapped_files_previous_action;
+static gsize mapped_files_page_size;
+
+
+static void on_mapped_file_sigbus(gint sig, siginfo_t *info, gpointer context)
+{
+	const gchar *addr = info->si_addr;
+	guint i;
+
+	for (i = 0; i < MAPPED_FILES_MAX; i++)
+	{
+		const gchar *start = mapped_files[i].start;
+		gsize len = mapped_files[i].len;
+
+		if (start != NULL && addr >= start && addr < start + len)
+		{
+			/* the mapping starts on a page, and everything after the fault is past the new end.
+			 * mmap() isn't async-signal-safe by POSIX but is only a system call. */
+			gsize offset = (addr - start) / mapped_files_page_size * mapped_files_page_size;
+
+			if (mmap((gpointer) (start + offset), len - offset, PROT_READ,
+					MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED)
+				return;
+			break;
+		}
+	}
+	/* not the text of a mapped file, so fault again with the previous handler */
+	sigaction(SIGBUS, &mapped_files_previous_action, NULL);
+}
+#endif
+
+
+/* Makes a truncation of the file of mapped read as zeros rather than crash Geany.
+ * Returns FALSE if this isn't possible and the file should not be shown mapped. */
+static gboolean mapped_file_register(GMappedFile *mapped)
+{
+#ifdef G_OS_UNIX
+	static gboolean handler_set = FALSE;
+	guint i;
+
+	if (! handler_set)
+	{
+		struct sigaction action;
+
+		memset(&action, 0, sizeof action);
+		action.sa_sigaction = on_mapped_file_sigbus;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		mapped_files_page_size = sysconf(_SC_PAGESIZE);
+		if (sigaction(SIGBUS, &action, &mapped_files_previous_action) != 0)
+			return FALSE;
+		handler_set = TRUE;
+	}
+	for (i = 0; i < MAPPED_FILES_MAX; i++)
+	{
+		if (mapped_files[i].start == NULL)
+		{
+			mapped_files[i].len = g_mapped_file_get_length(mapped);
+			mapped_files[i].start = g_mapped_file_get_contents(mapped);
+			return TRUE;
+		}
+	}
+	return FALSE;
+#else
+	/* Windows doesn't let a mapped file be truncated */
+	return TRUE;
+#endif
+}
+
+
+/* Releases a mapping registered by mapped_file_register(), once Scintilla no longer uses it */
+static void mapped_file_release(gpointer data)
+{
+	GMappedFile *mapped = data;
+#ifdef G_OS_UNIX
+	const gchar *contents = g_mapped_file_get_contents(mapped);
+	guint i;
+
+	for (i = 0; i < MAPPED_FILES_MAX; i++)
+	{
+		if (mapped_files[i].start == contents)
+		{
+			mapped_files[i].start = NULL;
+			break;
+		}
+	}
+#endif
+	g_mapped_file_unref(mapped);
+}
+
+
+/* Shows a huge UTF-8 file read-only from a memory mapping, so it opens without reading
+ * it into memory. Only the start of the file is checked for its encoding and line endings,
+ * and the document is not styled to save memory. Editing the document makes Scintilla copy
+ * the text first. Geany uses gint positions, which limits the file size to 2 GiB.
+ * The mapping is private, but a file truncated while mapped can't be read past its new end,
+ * so document_check_disk_status() replaces the document when the file changes, and until
+ * then mapped_file_register() makes the missing text read as zeros.
+ * Returns the document, or NULL if the file has to be loaded otherwise. */
+static gpointer load_text_file_mapped(const gchar *locale_filename, const gchar *display_filename,
+	FileData *filedata, const gchar *forced_enc)
+{
+	GMappedFile *mapped;
+	GStatBuf st, st_now;
+	struct stat st_fd;
+	const gchar *text, *end;
+	gsize len, check_len;
+	gpointer document;
+	gint fd;
+
+	if (g_stat(locale_filename, &st) != 0 || ! S_ISREG(st.st_mode) ||
+		st.st_size < MAPPED_LOAD_MIN_SIZE)
+		return NULL;
+	if (st.st_size > G_MAXINT)
+	{
+		ui_set_statusbar(TRUE, _("The file \"%s\" is too large to be shown from a memory mapping "
+			"and is read into memory. Positions beyond 2 GiB are not supported."), display_filename);
+		return NULL;
+	}
+
+	fd = g_open(locale_filename, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+	/* map exactly the file we checked */
+	if (fstat(fd, &st_fd) != 0 || st_fd.st_size != st.st_size || st_fd.st_mtime != st.st_mtime)
+	{
+		close(fd);
+		return NULL;
+	}
+	mapped = g_mapped_file_new_from_fd(fd, FALSE, NULL);
+	close(fd);
+	if (! mapped)
+		return NULL;
+	text = g_mapped_file_get_contents(mapped);
+	len = g_mapped_file_get_length(mapped);
+
+	/* invalid UTF-8 further on is just shown as such */
+	check_len = MIN(len, MAPPED_LOAD_CHECK_SIZE);
+	if (! encodings_is_utf8_candidate(text, check_len, forced_enc, &filedata->bom) ||
+		(! g_utf8_validate(text, check_len, &end) && text + check_len - end > 3))
+	{
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+	/* read a file that is being written to the normal way */
+	if (len != (gsize) st.st_size || g_stat(locale_filename, &st_now) != 0 ||
+		st_now.st_size != st.st_size || st_now.st_mtime != st.st_mtime)
+	{
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+	if (filedata->bom)
+	{
+		text += 3;
+		len -= 3;
+		check_len -= 3;
+	}
+	filedata->eol_mode = utils_get_line_endings(text, check_len);
+
+	if (! mapped_file_register(mapped))
+	{
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+	/* releases the mapping on failure */
+	document = sci_document_new_external(text, len, FALSE, mapped_file_release, mapped);
+	if (! document)
+		return NULL;
+
+	filedata->data = NULL;
+	filedata->len = 0;
+	filedata->enc = g_strdup("UTF-8");
+	filedata->mtime = st.st_mtime;
+	filedata->readonly = TRUE;
+	filedata->mapped = TRUE;
+
+	return document;
+}
+
+
 /* Sets the cursor position on opening a file. First it sets the line when cl_options.goto_line
  * is set, otherwise it sets the line when pos is greater than zero and finally it sets the column
  * if cl_options.goto_column is set.
@@ -1295,6 +1641,8 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 	FileData filedata;
 	UndoReloadData *undo_reload_data;
 	gboolean add_undo_reload_action;
+	gpointer sci_doc = NULL;
+	gboolean replace_sci_doc = FALSE;
 
 	g_return_val_if_fail(doc == NULL || doc->is_valid, NULL);
 
@@ -1334,8 +1682,24 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 	{	/* doc possibly changed */
 		display_filename = utils_str_middle_truncate(utf8_filename, 100);
 
-		if (! load_text_file(locale_filename, display_filename, &filedata, forced_enc))
+		/* big files are mapped or streamed directly into a new Scintilla document. This is not
+		 * done when reloading to keep the document, with its undo history and other views on it. */
+		if (! reload)
+		{
+			sci_doc = load_text_file_mapped(locale_filename, display_filename, &filedata, forced_enc);
+			if (! sci_doc)
+				sci_doc = load_text_file_streamed(locale_filename, &filedata, forced_enc);
+		}
+
+		if (! sci_doc && ! load_text_file(locale_filename, display_filename, &filedata, forced_enc))
 		{
+			/* stop showing a mapped file that changed, it may have been truncated */
+			if (reload && sci_has_external_text(doc->editor->sci))
+			{
+				set_sci_document(doc, sci_document_new(doc->editor->sci));
+				sci_set_readonly(doc->editor->sci, doc->readonly);
+				highlighting_set_styles(doc->editor->sci, doc->file_type);
+			}
 			g_free(display_filename);
 			g_free(utf8_filename);
 			g_free(locale_filename);
@@ -1353,8 +1717,17 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 			doc->priv->is_remote = utils_is_remote_path(locale_filename);
 			monitor_file_setup(doc);
 		}
+		else if (sci_has_external_text(doc->editor->sci))
+		{
+			/* replace a document showing a mapped file rather than reading its text, which
+			 * may be gone by now, and to get a document with styles. It has no edits to keep. */
+			replace_sci_doc = TRUE;
+			set_sci_document(doc, sci_document_new(doc->editor->sci));
+			if (doc->priv->info_bars[MSG_TYPE_MAPPED] != NULL)
+				gtk_info_bar_response(GTK_INFO_BAR(doc->priv->info_bars[MSG_TYPE_MAPPED]), GTK_RESPONSE_CANCEL);
+		}
 
-		if (! reload || ! file_prefs.keep_edit_history_on_reload)
+		if (! reload || replace_sci_doc || ! file_prefs.keep_edit_history_on_reload)
 		{
 			sci_set_undo_collection(doc->editor->sci, FALSE); /* avoid creation of an undo action */
 			sci_empty_undo_buffer(doc->editor->sci);
@@ -1382,11 +1755,19 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 		/* add the text to the ScintillaObject */
 		sci_set_readonly(doc->editor->sci, FALSE);	/* to allow replacing text */
-		sci_set_text(doc->editor->sci, filedata.data);	/* NULL terminated data */
+		if (sci_doc)
+		{
+			set_sci_document(doc, sci_doc);
+			editor_mode = filedata.eol_mode;
+		}
+		else
+		{
+			sci_set_text(doc->editor->sci, filedata.data);	/* NULL terminated data */
+			/* detect & set line endings */
+			editor_mode = utils_get_line_endings(filedata.data, filedata.len);
+		}
 		queue_colourise(doc);	/* Ensure the document gets colourised. */
 
-		/* detect & set line endings */
-		editor_mode = utils_get_line_endings(filedata.data, filedata.len);
 		if (undo_reload_data)
 		{
 			undo_reload_data->eol_mode = editor_get_eol_char_mode(doc->editor);
@@ -1467,6 +1848,12 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		}
 		/* update taglist, typedef keywords and build menu if necessary */
 		document_set_filetype(doc, use_ft);
+		/* the lexer belongs to the replaced document */
+		if (replace_sci_doc)
+		{
+			highlighting_set_styles(doc->editor->sci, doc->file_type);
+			queue_colourise(doc);
+		}
 
 		/* set indentation settings after setting the filetype */
 		if (reload)
@@ -1495,6 +1882,9 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 			msgwin_status_add(_("File %s opened (%d%s)."),
 				display_filename, gtk_notebook_get_n_pages(GTK_NOTEBOOK(main_widgets.notebook)),
 				(readonly) ? _(", read-only") : "");
+
+			if (filedata.mapped)
+				show_mapped_file_message(doc);
 		}
 
 		/* now the document is fully ready, display it (see notebook_new_tab()) */
@@ -2182,6 +2572,10 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 
 	locale_filename = utils_get_locale_from_utf8(doc->file_name);
 
+	/* copy the text of a memory mapped file before the file is overwritten */
+	if (sci_has_external_text(doc->editor->sci))
+		SSM(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
+
 	/* ignore file changed notification when the file is written */
 	doc->priv->file_disk_status = FILE_IGNORE;
 
@@ -2689,9 +3083,10 @@ void document_update_tags(GeanyDocument *doc)
 	}
 
 	/* Parse Scintilla's buffer directly using TagManager
-	 * Note: this buffer *MUST NOT* be modified */
+	 * Note: this buffer *MUST NOT* be modified. Unlike SCI_GETCHARACTERPOINTER,
+	 * SCI_GETRANGEPOINTER doesn't copy the text of a file shown from a memory mapping. */
 	len = sci_get_length(doc->editor->sci);
-	buffer_ptr = (guchar *) SSM(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
+	buffer_ptr = (guchar *) SSM(doc->editor->sci, SCI_GETRANGEPOINTER, 0, len);
 	tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
 
 	sidebar_update_tag_list(doc, TRUE);
@@ -3003,6 +3398,13 @@ void document_undo(GeanyDocument *doc)
 		{
 			case UNDO_SCINTILLA:
 			{
+				/* Scintilla drops its oldest history when it exceeds
+				 * undo_memory_limit, anything older can't be undone either */
+				if (! sci_can_undo(doc->editor->sci) && ! doc->readonly)
+				{
+					document_undo_clear_stack(&doc->priv->undo_actions);
+					break;
+				}
 				document_redo_add(doc, UNDO_SCINTILLA, NULL);
 
 				sci_undo(doc->editor->sci);
@@ -3337,16 +3739,30 @@ GeanyDocument *document_clone(GeanyDocument *old_doc)
 	gchar *text;
 	GeanyDocument *doc;
 	ScintillaObject *old_sci;
+	gpointer sci_doc;
 
 	g_return_val_if_fail(old_doc, NULL);
 	old_sci = old_doc->editor->sci;
 	if (sci_has_selection(old_sci))
+	{
 		text = sci_get_selection_contents(old_sci);
+		doc = document_new_file(NULL, old_doc->file_type, text);
+		g_free(text);
+	}
 	else
-		text = sci_get_contents(old_sci, -1);
-
-	doc = document_new_file(NULL, old_doc->file_type, text);
-	g_free(text);
+	{
+		/* share the text with the original document until either is changed, but copy a
+		 * memory mapped file as the new document isn't checked for the file changing */
+		sci_doc = sci_has_external_text(old_sci) ? NULL : sci_document_clone(old_sci);
+		if (sci_doc)
+			doc = new_file(NULL, old_doc->file_type, NULL, sci_doc);
+		else
+		{
+			text = sci_get_contents(old_sci, -1);
+			doc = document_new_file(NULL, old_doc->file_type, text);
+			g_free(text);
+		}
+	}
 	document_set_text_changed(doc, TRUE);
 
 	/* copy file properties */
@@ -3527,6 +3943,38 @@ static GtkWidget* document_show_message(GeanyDocument *doc, GtkMessageType msgty
 }
 
 
+static void on_mapped_file_response(GtkWidget *bar, gint response_id, GeanyDocument *doc)
+{
+	doc->priv->info_bars[MSG_TYPE_MAPPED] = NULL;
+	gtk_widget_destroy(bar);
+
+	if (response_id == RESPONSE_DOCUMENT_RELOAD)
+	{
+		/* it was only opened read-only because of the mapping */
+		doc->readonly = FALSE;
+		document_reload_force(doc, doc->encoding);
+	}
+}
+
+
+/* Tells that doc shows a huge file from a memory mapping, without syntax highlighting
+ * as long as it is not loaded fully. */
+static void show_mapped_file_message(GeanyDocument *doc)
+{
+	gchar *base_name = g_path_get_basename(doc->file_name);
+
+	doc->priv->info_bars[MSG_TYPE_MAPPED] = document_show_message(doc, GTK_MESSAGE_INFO,
+			on_mapped_file_response,
+			_("_Load Fully"), RESPONSE_DOCUMENT_RELOAD,
+			GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE,
+			NULL, GTK_RESPONSE_NONE,
+			_("Loading it into memory allows syntax highlighting, but takes time and as much memory as the file's size."),
+			_("The file '%s' is very large and is shown read-only, directly from the disk and without syntax highlighting."),
+			base_name);
+	g_free(base_name);
+}
+
+
 static void on_monitor_reload_file_response(GtkWidget *bar, gint response_id, GeanyDocument *doc)
 {
 	gboolean close = FALSE;
@@ -3722,6 +4170,14 @@ gboolean document_check_disk_status(GeanyDocument *doc, gboolean force)
 		/* doc may be closed now */
 		ret = TRUE;
 	}
+	else if (doc->priv->mtime < mtime && sci_has_external_text(doc->editor->sci))
+	{
+		/* a file shown from a memory mapping may have been truncated, when reading past
+		 * its end would crash, so replace the document right away. It has no edits. */
+		doc->priv->mtime = mtime;
+		document_reload_force(doc, doc->encoding);
+		ret = TRUE;
+	}
 	else if (doc->priv->mtime < mtime)
 	{
 		/* make sure the user is not prompted again after he cancelled the "reload file?" message */
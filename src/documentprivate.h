@@ -66,6 +66,7 @@ enum
 	MSG_TYPE_RELOAD,
 	MSG_TYPE_RESAVE,
 	MSG_TYPE_POST_RELOAD,
+	MSG_TYPE_MAPPED,
 
 	NUM_MSG_TYPES
 };
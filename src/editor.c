@@ -91,6 +91,30 @@ static struct
 
 static gchar indent[100];
 
+/* documents with at least this many lines are styled in idle time, see editor_check_colourise() */
+#define IDLE_STYLING_MIN_LINES 10000
+/* documents with at least this many lines or bytes keep the layout of all lines cached,
+ * see editor_check_colourise() */
+#define LAYOUT_CACHE_DOCUMENT_MIN_LINES 5000
+#define LAYOUT_CACHE_DOCUMENT_MIN_LENGTH (1024 * 1024)
+
+static struct
+{
+	guint source_id;
+	guint doc_id;
+} idle_styling_progress = {0, 0};
+
+/* The last tags or document words autocompletion list, narrowed down as the user
+ * types instead of being rebuilt as long as it has every match for its root */
+static struct
+{
+	ScintillaObject *sci;
+	gint pos;				/* start of the word being completed */
+	gconstpointer source;	/* filetype of the tags, NULL for document words */
+	gchar *root;
+	GPtrArray *items;		/* NULL-terminated */
+} autocomplete_list = {NULL, -1, NULL, NULL, NULL};
+
 
 static void on_new_line_added(GeanyEditor *editor);
 static gboolean handle_xml(GeanyEditor *editor, gint pos, gchar ch);
@@ -589,54 +613,111 @@ static void check_line_breaking(GeanyEditor *editor, gint pos)
 }
 
 
-static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GString *words)
+/* items must be NULL-terminated */
+static void show_autocomplete(ScintillaObject *sci, gsize rootlen, GPtrArray *items)
 {
+	/* any list shown replaces the one kept for narrowing down */
+	autocomplete_list.sci = NULL;
+
 	/* hide autocompletion if only option is already typed */
-	if (rootlen >= words->len ||
-		(words->str[rootlen] == '?' && rootlen >= words->len - 2))
+	if (items->len < 2 ||
+		(items->len == 2 && strcspn(items->pdata[0], "?") <= rootlen))
 	{
 		sci_send_command(sci, SCI_AUTOCCANCEL);
 		return;
 	}
 	/* store whether a calltip is showing, so we can reshow it after autocompletion */
 	calltip.set = (gboolean) SSM(sci, SCI_CALLTIPACTIVE, 0, 0);
-	SSM(sci, SCI_AUTOCSHOW, rootlen, (sptr_t) words->str);
+	SSM(sci, SCI_AUTOCSHOWITEMS, rootlen, (sptr_t) items->pdata);
 }
 
 
-static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize rootlen)
+/* Takes ownership of items */
+static void autocomplete_list_set(ScintillaObject *sci, gconstpointer source,
+		const gchar *root, gsize rootlen, GPtrArray *items)
 {
-	ScintillaObject *sci = editor->sci;
+	if (autocomplete_list.items)
+		g_ptr_array_free(autocomplete_list.items, TRUE);
+	g_free(autocomplete_list.root);
 
-	g_return_if_fail(tags);
+	autocomplete_list.sci = sci;
+	autocomplete_list.pos = sci_get_current_position(sci) - rootlen;
+	autocomplete_list.source = source;
+	autocomplete_list.root = g_strdup(root);
+	autocomplete_list.items = items;
+}
 
-	if (tags->len > 0)
+
+/* Shows the entries of the list still being shown for source which match root,
+ * if root only extends the root of that list.
+ * Returns: whether there were any such entries. */
+static gboolean autocomplete_list_narrow(ScintillaObject *sci, gconstpointer source,
+		const gchar *root, gsize rootlen)
+{
+	GPtrArray *items;
+	guint i;
+
+	if (autocomplete_list.sci != sci || autocomplete_list.source != source ||
+		autocomplete_list.pos != sci_get_current_position(sci) - (gint) rootlen ||
+		!g_str_has_prefix(root, autocomplete_list.root) ||
+		!SSM(sci, SCI_AUTOCACTIVE, 0, 0))
+		return FALSE;
+
+	items = g_ptr_array_new_full(autocomplete_list.items->len, g_free);
+	for (i = 0; i + 1 < autocomplete_list.items->len; i++)
 	{
-		GString *words = g_string_sized_new(150);
-		guint j;
+		const gchar *item = autocomplete_list.items->pdata[i];
 
-		for (j = 0; j < tags->len; ++j)
-		{
-			TMTag *tag = tags->pdata[j];
+		/* document words are only completions if longer than the root */
+		if (g_str_has_prefix(item, root) && (source || strlen(item) > rootlen))
+			g_ptr_array_add(items, g_strdup(item));
+	}
+	g_ptr_array_add(items, NULL);
 
-			if (j > 0)
-				g_string_append_c(words, '\n');
+	if (items->len < 2)
+	{
+		g_ptr_array_free(items, TRUE);
+		return FALSE;
+	}
+	show_autocomplete(sci, rootlen, items);
+	autocomplete_list_set(sci, source, root, rootlen, items);
+	return TRUE;
+}
 
-			if (j == editor_prefs.autocompletion_max_entries)
-			{
-				g_string_append(words, "...");
-				break;
-			}
-			g_string_append(words, tag->name);
 
-			/* for now, tag types don't all follow C, so just look at arglist */
-			if (!EMPTY(tag->arglist))
-				g_string_append(words, "?2");
-			else
-				g_string_append(words, "?1");
+/* Returns: a NULL-terminated array of autocompletion items for tags. */
+static GPtrArray *get_tags_items(const GPtrArray *tags)
+{
+	GPtrArray *items = g_ptr_array_new_full(tags->len + 1, g_free);
+	guint j;
+
+	for (j = 0; j < tags->len; ++j)
+	{
+		TMTag *tag = tags->pdata[j];
+
+		if (j == editor_prefs.autocompletion_max_entries)
+		{
+			g_ptr_array_add(items, g_strdup("..."));
+			break;
 		}
-		show_autocomplete(sci, rootlen, words);
-		g_string_free(words, TRUE);
+		/* for now, tag types don't all follow C, so just look at arglist */
+		g_ptr_array_add(items, g_strconcat(tag->name, EMPTY(tag->arglist) ? "?1" : "?2", NULL));
+	}
+	g_ptr_array_add(items, NULL);
+	return items;
+}
+
+
+static void show_tags_list(GeanyEditor *editor, const GPtrArray *tags, gsize rootlen)
+{
+	g_return_if_fail(tags);
+
+	if (tags->len > 0)
+	{
+		GPtrArray *items = get_tags_items(tags);
+
+		show_autocomplete(editor->sci, rootlen, items);
+		g_ptr_array_free(items, TRUE);
 	}
 }
 
@@ -2075,10 +2156,22 @@ autocomplete_tags(GeanyEditor *editor, GeanyFiletype *ft, const gchar *root, gsi
 
 	g_return_val_if_fail(editor, FALSE);
 
+	if (autocomplete_list_narrow(editor->sci, ft, root, rootlen))
+		return TRUE;
+
 	tags = tm_workspace_find_prefix(root, ft->lang, editor_prefs.autocompletion_max_entries);
 	found = tags->len > 0;
 	if (found)
-		show_tags_list(editor, tags, rootlen);
+	{
+		GPtrArray *items = get_tags_items(tags);
+
+		show_autocomplete(editor->sci, rootlen, items);
+		/* with fewer tags than the maximum, the list has all of them */
+		if (tags->len < editor_prefs.autocompletion_max_entries)
+			autocomplete_list_set(editor->sci, ft, root, rootlen, items);
+		else
+			g_ptr_array_free(items, TRUE);
+	}
 	g_ptr_array_free(tags, TRUE);
 
 	return found;
@@ -2181,8 +2274,10 @@ static gboolean autocomplete_doc_word(GeanyEditor *editor, gchar *root, gsize ro
 {
 	ScintillaObject *sci = editor->sci;
 	GSList *words, *node;
-	GString *str;
-	guint n_words = 0;
+	GPtrArray *items;
+
+	if (autocomplete_list_narrow(sci, NULL, root, rootlen))
+		return TRUE;
 
 	words = get_doc_words(sci, root, rootlen);
 	if (!words)
@@ -2191,22 +2286,24 @@ static gboolean autocomplete_doc_word(GeanyEditor *editor, gchar *root, gsize ro
 		return FALSE;
 	}
 
-	str = g_string_sized_new(rootlen * 2 * 10);
+	items = g_ptr_array_new_with_free_func(g_free);
 	foreach_slist(node, words)
-	{
-		g_string_append(str, node->data);
-		g_free(node->data);
-		if (node->next)
-			g_string_append_c(str, '\n');
-		n_words++;
-	}
-	if (n_words >= editor_prefs.autocompletion_max_entries)
-		g_string_append(str, "\n...");
-
+		g_ptr_array_add(items, node->data);
 	g_slist_free(words);
 
-	show_autocomplete(sci, rootlen, str);
-	g_string_free(str, TRUE);
+	if (items->len >= editor_prefs.autocompletion_max_entries)
+	{
+		g_ptr_array_add(items, g_strdup("..."));
+		g_ptr_array_add(items, NULL);
+		show_autocomplete(sci, rootlen, items);
+		g_ptr_array_free(items, TRUE);
+	}
+	else
+	{
+		g_ptr_array_add(items, NULL);
+		show_autocomplete(sci, rootlen, items);
+		autocomplete_list_set(sci, NULL, root, rootlen, items);
+	}
 	return TRUE;
 }
 
@@ -4038,6 +4135,10 @@ void editor_indentation_by_one_space(GeanyEditor *editor, gint pos, gboolean dec
 
 void editor_finalize(void)
 {
+	if (autocomplete_list.items)
+		g_ptr_array_free(autocomplete_list.items, TRUE);
+	g_free(autocomplete_list.root);
+
 	scintilla_release_resources();
 }
 
@@ -4154,26 +4255,14 @@ void editor_indicator_clear(GeanyEditor *editor, gint indic)
 }
 
 
-/**
- *  Sets an indicator @a indic on @a line.
- *  Whitespace at the start and the end of the line is not marked.
- *
- *  @param editor The editor to operate on.
- *  @param indic The indicator number to use, this is a value of @ref GeanyIndicator.
- *  @param line The line number which should be marked.
- *
- *  @since 0.16
- */
-GEANY_API_SYMBOL
-void editor_indicator_set_on_line(GeanyEditor *editor, gint indic, gint line)
+/* Gets the range of line without leading and trailing whitespace.
+ * Returns FALSE for blank lines. */
+static gboolean get_line_indicator_range(GeanyEditor *editor, gint line, gint *start_out, gint *end_out)
 {
 	gint start, end;
 	guint i = 0, len;
 	gchar *linebuf;
 
-	g_return_if_fail(editor != NULL);
-	g_return_if_fail(line >= 0);
-
 	start = sci_get_position_from_line(editor->sci, line);
 	end = sci_get_position_from_line(editor->sci, line + 1);
 
@@ -4182,7 +4271,7 @@ void editor_indicator_set_on_line(GeanyEditor *editor, gint indic, gint line)
 		start > end ||
 		(sci_get_line_end_position(editor->sci, line) - start) == 0)
 	{
-		return;
+		return FALSE;
 	}
 
 	len = end - start;
@@ -4198,7 +4287,54 @@ void editor_indicator_set_on_line(GeanyEditor *editor, gint indic, gint line)
 	}
 	g_free(linebuf);
 
-	editor_indicator_set_on_range(editor, indic, start + i, end);
+	*start_out = start + i;
+	*end_out = end;
+	return TRUE;
+}
+
+
+/**
+ *  Sets an indicator @a indic on @a line.
+ *  Whitespace at the start and the end of the line is not marked.
+ *
+ *  @param editor The editor to operate on.
+ *  @param indic The indicator number to use, this is a value of @ref GeanyIndicator.
+ *  @param line The line number which should be marked.
+ *
+ *  @since 0.16
+ */
+GEANY_API_SYMBOL
+void editor_indicator_set_on_line(GeanyEditor *editor, gint indic, gint line)
+{
+	gint start, end;
+
+	g_return_if_fail(editor != NULL);
+	g_return_if_fail(line >= 0);
+
+	if (get_line_indicator_range(editor, line, &start, &end))
+		editor_indicator_set_on_range(editor, indic, start, end);
+}
+
+
+/* Like editor_indicator_set_on_line() for n_lines lines, updating the indicator once. */
+void editor_indicator_set_on_lines(GeanyEditor *editor, gint indic, const gint *lines, guint n_lines)
+{
+	gint *ranges;
+	guint i, n_ranges = 0;
+
+	g_return_if_fail(editor != NULL);
+
+	ranges = g_new(gint, n_lines * 2);
+	for (i = 0; i < n_lines; i++)
+	{
+		if (lines[i] >= 0 &&
+			get_line_indicator_range(editor, lines[i], &ranges[n_ranges * 2], &ranges[n_ranges * 2 + 1]))
+		{
+			n_ranges++;
+		}
+	}
+	editor_indicator_set_on_ranges(editor, indic, ranges, n_ranges);
+	g_free(ranges);
 }
 
 
@@ -4226,6 +4362,35 @@ void editor_indicator_set_on_range(GeanyEditor *editor, gint indic, gint start,
 }
 
 
+/* Sets an indicator on n_ranges ranges given as start and end pairs in ranges, in any order.
+ * Scintilla updates the indicator and redraws only once, so this is much faster than
+ * calling editor_indicator_set_on_range() for each of many ranges. */
+void editor_indicator_set_on_ranges(GeanyEditor *editor, gint indic, const gint *ranges, guint n_ranges)
+{
+	Sci_Position *fill;
+	guint i, n_fill = 0;
+
+	g_return_if_fail(editor != NULL);
+
+	fill = g_new(Sci_Position, n_ranges * 2);
+	for (i = 0; i < n_ranges; i++)
+	{
+		if (ranges[i * 2] < ranges[i * 2 + 1])
+		{
+			fill[n_fill * 2] = ranges[i * 2];
+			fill[n_fill * 2 + 1] = ranges[i * 2 + 1] - ranges[i * 2];
+			n_fill++;
+		}
+	}
+	if (n_fill > 0)
+	{
+		sci_indicator_set(editor->sci, indic);
+		sci_indicator_fill_ranges(editor->sci, fill, n_fill);
+	}
+	g_free(fill);
+}
+
+
 /* Inserts the given colour (format should be #...), if there is a selection starting with 0x...
  * the replacement will also start with 0x... */
 void editor_insert_color(GeanyEditor *editor, const gchar *colour)
@@ -4352,24 +4517,16 @@ const gchar *editor_get_eol_char(GeanyEditor *editor)
 
 static void fold_all(GeanyEditor *editor, gboolean want_fold)
 {
-	gint lines, first, i;
+	gint first;
 
 	if (editor == NULL || ! editor_prefs.folding)
 		return;
 
-	lines = sci_get_line_count(editor->sci);
 	first = sci_get_first_visible_line(editor->sci);
 
-	for (i = 0; i < lines; i++)
-	{
-		gint level = sci_get_fold_level(editor->sci, i);
-
-		if (level & SC_FOLDLEVELHEADERFLAG)
-		{
-			if (sci_get_fold_expanded(editor->sci, i) == want_fold)
-					sci_toggle_fold(editor->sci, i);
-		}
-	}
+	/* one call updates the whole fold state, rather than toggling each header */
+	sci_fold_all(editor->sci, want_fold ?
+		SC_FOLDACTION_CONTRACT | SC_FOLDACTION_CONTRACT_EVERY_LEVEL : SC_FOLDACTION_EXPAND);
 	editor_scroll_to_line(editor, first, 0.0F);
 }
 
@@ -4764,6 +4921,62 @@ on_editor_scroll_event(GtkWidget *widget, GdkEventScroll *event, gpointer user_d
 }
 
 
+static gboolean update_idle_styling_progress(gpointer data)
+{
+	GeanyDocument *doc = document_find_by_id(idle_styling_progress.doc_id);
+	gint length, end_styled;
+
+	/* a build or search took over the progress bar, leave it to them */
+	if (ui_progress_bar_is_running())
+	{
+		idle_styling_progress.source_id = 0;
+		return FALSE;
+	}
+
+	/* only the current document's progress is shown, but others are still styled */
+	if (doc == NULL || doc != document_get_current())
+	{
+		idle_styling_progress.source_id = 0;
+		gtk_widget_hide(main_widgets.progressbar);
+		return FALSE;
+	}
+
+	length = sci_get_length(doc->editor->sci);
+	end_styled = sci_get_end_styled(doc->editor->sci);
+	if (end_styled >= length)
+	{
+		idle_styling_progress.source_id = 0;
+		gtk_widget_hide(main_widgets.progressbar);
+		/* fold points are accurate now */
+		symbols_get_current_function(NULL, NULL);
+		ui_update_statusbar(doc, -1);
+		return FALSE;
+	}
+
+	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(main_widgets.progressbar),
+		end_styled / (gdouble) length);
+	return TRUE;
+}
+
+
+static void start_idle_styling_progress(GeanyDocument *doc)
+{
+	idle_styling_progress.doc_id = doc->id;
+	if (idle_styling_progress.source_id != 0)
+		return;
+
+	/* don't take over the progress bar while it is used for something else */
+	if (! interface_prefs.statusbar_visible || ui_progress_bar_is_running() ||
+		gtk_widget_get_visible(main_widgets.progressbar))
+		return;
+
+	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(main_widgets.progressbar), 0.0);
+	gtk_progress_bar_set_text(GTK_PROGRESS_BAR(main_widgets.progressbar), _("Highlighting"));
+	gtk_widget_show(main_widgets.progressbar);
+	idle_styling_progress.source_id = g_timeout_add(200, update_idle_styling_progress, NULL);
+}
+
+
 static gboolean editor_check_colourise(GeanyEditor *editor)
 {
 	GeanyDocument *doc = editor->document;
@@ -4772,7 +4985,31 @@ static gboolean editor_check_colourise(GeanyEditor *editor)
 		return FALSE;
 
 	doc->priv->colourise_needed = FALSE;
-	sci_colourise(editor->sci, 0, -1);
+
+	/* Small documents are quickly laid out again when redrawn, but in big ones keep the
+	 * layout of lines scrolled past. This also keeps the layout of a very long line when
+	 * the caret moves off it, so editing it later only measures the changed part.
+	 * Scintilla limits the memory used by this cache. */
+	if (sci_get_line_count(editor->sci) >= LAYOUT_CACHE_DOCUMENT_MIN_LINES ||
+		sci_get_length(editor->sci) >= LAYOUT_CACHE_DOCUMENT_MIN_LENGTH)
+		sci_set_layout_cache(editor->sci, SC_CACHE_DOCUMENT);
+	else
+		sci_set_layout_cache(editor->sci, SC_CACHE_PAGE);
+
+	if (sci_get_line_count(editor->sci) >= IDLE_STYLING_MIN_LINES)
+	{
+		/* Styling a big document at once would block the UI, so let Scintilla style the
+		 * visible lines when drawing them and the rest in idle time. Colourising the first
+		 * line restarts styling from the beginning, in case the highlighting changed. */
+		sci_set_idle_styling(editor->sci, SC_IDLESTYLING_ALL);
+		sci_colourise(editor->sci, 0, sci_get_position_from_line(editor->sci, 1));
+		start_idle_styling_progress(doc);
+	}
+	else
+	{
+		sci_set_idle_styling(editor->sci, SC_IDLESTYLING_NONE);
+		sci_colourise(editor->sci, 0, -1);
+	}
 
 	/* now that the current document is colourised, fold points are now accurate,
 	 * so force an update of the current function/tag. */
@@ -5202,6 +5439,9 @@ void editor_apply_update_prefs(GeanyEditor *editor)
 	sci_set_scroll_stop_at_last_line(sci, editor_prefs.scroll_stop_at_last_line);
 
 	sci_set_scrollbar_mode(sci, editor_prefs.show_scrollbars);
+
+	/* the limit belongs to the Scintilla document, so it is set again after replacing that */
+	sci_set_undo_memory_limit(sci, (gsize) MAX(editor_prefs.undo_memory_limit, 0) * 1024 * 1024);
 }
 
 
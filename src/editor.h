@@ -138,6 +138,7 @@ typedef struct GeanyEditorPrefs
 	gint		autocompletion_update_freq;
 	gint		scroll_lines_around_cursor;
 	gint		ime_interaction; /* input method editor's candidate window behaviour */
+	gint		undo_memory_limit; /* MiB of undo history kept per document, 0 for no limit (hidden pref) */
 }
 GeanyEditorPrefs;
 
@@ -299,6 +300,10 @@ void editor_set_font(GeanyEditor *editor, const gchar *font);
 
 void editor_indicator_clear_errors(GeanyEditor *editor);
 
+void editor_indicator_set_on_ranges(GeanyEditor *editor, gint indic, const gint *ranges, guint n_ranges);
+
+void editor_indicator_set_on_lines(GeanyEditor *editor, gint indic, const gint *lines, guint n_lines);
+
 void editor_fold_all(GeanyEditor *editor);
 
 void editor_unfold_all(GeanyEditor *editor);
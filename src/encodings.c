@@ -1083,3 +1083,38 @@ gboolean encodings_convert_to_utf8_auto(gchar **buf, gsize *size, const gchar *f
 	*buf = buffer.data;
 	return TRUE;
 }
+
+
+/*
+ * Checks whether encodings_convert_to_utf8_auto() would use data starting with
+ * @a head as UTF-8 without converting it, provided the whole data turns out to
+ * be valid UTF-8 without null bytes. This allows loading such data piecewise.
+ *
+ * @param head the start of the data, at least its first 512 bytes or all of it if shorter.
+ * @param len the length of @a head.
+ * @param forced_enc forced encoding to use, or @c NULL
+ * @param has_bom return location to store whether the data starts with a UTF-8 BOM
+ *
+ * @return @c TRUE if the data can be used as UTF-8.
+ */
+gboolean encodings_is_utf8_candidate(const gchar *head, gsize len, const gchar *forced_enc,
+		gboolean *has_bom)
+{
+	GeanyEncodingIndex enc_idx = encodings_scan_unicode_bom(head, len, NULL);
+	gboolean utf8;
+
+	*has_bom = (enc_idx == GEANY_ENCODING_UTF_8);
+	if (forced_enc != NULL)
+		return utils_str_equal(forced_enc, "UTF-8");
+	else if (enc_idx != GEANY_ENCODING_NONE)
+		return enc_idx == GEANY_ENCODING_UTF_8;
+	else
+	{
+		/* the encoding from the file content, like handle_encoding() */
+		gchar *regex_charset = encodings_check_regexes(head, len);
+
+		utf8 = encodings_get_idx_from_charset(regex_charset) == GEANY_ENCODING_UTF_8;
+		g_free(regex_charset);
+		return utf8;
+	}
+}
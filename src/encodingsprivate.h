@@ -74,6 +74,9 @@ gboolean encodings_is_unicode_charset(const gchar *string);
 gboolean encodings_convert_to_utf8_auto(gchar **buf, gsize *size, const gchar *forced_enc,
                                         gchar **used_encoding, gboolean *has_bom, gboolean *partial);
 
+gboolean encodings_is_utf8_candidate(const gchar *head, gsize len, const gchar *forced_enc,
+                                     gboolean *has_bom);
+
 GeanyEncodingIndex encodings_scan_unicode_bom(const gchar *string, gsize len, guint *bom_len);
 
 GeanyEncodingIndex encodings_get_idx_from_charset(const gchar *charset);
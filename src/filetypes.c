@@ -464,18 +464,43 @@ void filetypes_init(void)
 }
 
 
-static guint match_basename(const GeanyFiletype *ft, const gchar *base_filename)
+static void free_pattern_specs(GeanyFiletype *ft)
 {
+	if (ft->priv->pattern_specs)
+	{
+		g_ptr_array_free(ft->priv->pattern_specs, TRUE);
+		ft->priv->pattern_specs = NULL;
+	}
+}
+
+
+/* Compiling the patterns again for each file name adds up when detecting the
+ * filetypes of many files, so they are kept until ft->pattern is replaced. */
+static GPtrArray *get_pattern_specs(GeanyFiletype *ft)
+{
+	if (!ft->priv->pattern_specs)
+	{
+		ft->priv->pattern_specs = g_ptr_array_new_with_free_func((GDestroyNotify) g_pattern_spec_free);
+		for (guint j = 0; ft->pattern[j] != NULL; j++)
+			g_ptr_array_add(ft->priv->pattern_specs, g_pattern_spec_new(ft->pattern[j]));
+	}
+	return ft->priv->pattern_specs;
+}
+
+
+static guint match_basename(GeanyFiletype *ft, const gchar *base_filename, guint base_len)
+{
+	GPtrArray *specs;
+
 	if (G_UNLIKELY(ft->id == GEANY_FILETYPES_NONE))
 		return 0;
 
-	for (guint j = 0; ft->pattern[j] != NULL; j++)
+	specs = get_pattern_specs(ft);
+	for (guint j = 0; j < specs->len; j++)
 	{
-		gchar *pat = ft->pattern[j];
-		
-		if (g_pattern_match_simple(pat, base_filename))
+		if (g_pattern_match(specs->pdata[j], base_len, base_filename, NULL))
 		{
-			return strlen(pat);
+			return strlen(ft->pattern[j]);
 		}
 	}
 	return 0;
@@ -517,6 +542,7 @@ GeanyFiletype *filetypes_detect_from_extension(const gchar *utf8_filename)
 	gchar *base_filename;
 	GeanyFiletype *ft;
 	guint plen = 0;
+	guint base_len;
 
 	ft = detect_filetype_conf_file(utf8_filename);
 	if (ft)
@@ -528,10 +554,11 @@ GeanyFiletype *filetypes_detect_from_extension(const gchar *utf8_filename)
 	/* use lower case basename */
 	SETPTR(base_filename, g_utf8_strdown(base_filename, -1));
 #endif
+	base_len = strlen(base_filename);
 
 	for (guint i = 0; i < filetypes_array->len; i++)
 	{
-		guint mlen = match_basename(filetypes[i], base_filename);
+		guint mlen = match_basename(filetypes[i], base_filename, base_len);
 		
 		if (mlen > plen)
 		{	// longest pattern match wins
@@ -837,6 +864,7 @@ static void filetype_free(gpointer data, G_GNUC_UNUSED gpointer user_data)
 	if (ft->icon)
 		g_object_unref(ft->icon);
 	g_strfreev(ft->pattern);
+	free_pattern_specs(ft);
 
 	if (ft->priv->error_regex)
 		g_regex_unref(ft->priv->error_regex);
@@ -1391,6 +1419,7 @@ static void read_extensions(GKeyFile *sysconfig, GKeyFile *userconfig)
 
 		filetypes[i]->priv->user_extensions = userset;
 		g_strfreev(filetypes[i]->pattern);
+		free_pattern_specs(filetypes[i]);
 		/* Note: we allow 'Foo=' to remove all patterns */
 		if (!list)
 			list = g_new0(gchar*, 1);
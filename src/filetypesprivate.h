@@ -41,6 +41,7 @@ typedef struct GeanyFiletypePrivate
 	GSList		*tag_files;
 	gboolean	warn_color_scheme;
 	gboolean	user_extensions;	// true if extensions were read from user config file
+	GPtrArray	*pattern_specs;		// compiled ft->pattern, created on demand
 
 	/* TODO: move to structure in build.h and only put a pointer here */
 	GeanyBuildCommand *filecmds;
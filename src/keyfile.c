@@ -243,6 +243,8 @@ static void init_pref_groups(void)
 		"indent_hard_tab_width", 8);
 	stash_group_add_integer(group, &editor_prefs.ime_interaction,
 		"editor_ime_interaction", SC_IME_WINDOWED);
+	stash_group_add_integer(group, &editor_prefs.undo_memory_limit,
+		"undo_memory_limit", 0);
 
 	group = stash_group_new(PACKAGE);
 	configuration_add_various_pref_group(group, "files");
@@ -282,6 +282,20 @@ void sci_empty_undo_buffer(ScintillaObject *sci)
 }
 
 
+/* Limits the undo history to about bytes, dropping the oldest actions. 0 means no limit. */
+void sci_set_undo_memory_limit(ScintillaObject *sci, gsize bytes)
+{
+	SSM(sci, SCI_SETUNDOMEMORYLIMIT, (uptr_t) bytes, 0);
+}
+
+
+/* Returns the number of bytes used by the undo history. */
+gsize sci_get_undo_memory(ScintillaObject *sci)
+{
+	return (gsize) SSM(sci, SCI_GETUNDOMEMORY, 0, 0);
+}
+
+
 gboolean sci_is_modified(ScintillaObject *sci)
 {
 	return (SSM(sci, SCI_GETMODIFY, 0, 0) != 0);
@@ -764,6 +778,13 @@ void sci_toggle_fold(ScintillaObject *sci, gint line)
 }
 
 
+/* action is one of the SC_FOLDACTION_* values */
+void sci_fold_all(ScintillaObject *sci, gint action)
+{
+	SSM(sci, SCI_FOLDALL, (uptr_t) action, 0);
+}
+
+
 gboolean sci_get_fold_expanded(ScintillaObject *sci, gint line)
 {
 	return SSM(sci, SCI_GETFOLDEXPANDED, (uptr_t) line, 0) != FALSE;
@@ -776,6 +797,21 @@ void sci_colourise(ScintillaObject *sci, gint start, gint end)
 }
 
 
+/* Sets which part of the document is styled in idle time instead of before drawing,
+ * as a SC_IDLESTYLING_* value. */
+void sci_set_idle_styling(ScintillaObject *sci, gint mode)
+{
+	SSM(sci, SCI_SETIDLESTYLING, (uptr_t) mode, 0);
+}
+
+
+/* Sets which lines keep their layout between redraws, as a SC_CACHE_* value. */
+void sci_set_layout_cache(ScintillaObject *sci, gint mode)
+{
+	SSM(sci, SCI_SETLAYOUTCACHE, (uptr_t) mode, 0);
+}
+
+
 void sci_clear_all(ScintillaObject *sci)
 {
 	SSM(sci, SCI_CLEARALL, 0, 0);
@@ -1169,6 +1205,13 @@ void sci_indicator_fill(ScintillaObject *sci, gint pos, gint len)
 }
 
 
+/* Fills the current indicator on count ranges given as start and length pairs. */
+void sci_indicator_fill_ranges(ScintillaObject *sci, const Sci_Position *ranges, guint count)
+{
+	SSM(sci, SCI_INDICATORFILLRANGES, (uptr_t) count, (sptr_t) ranges);
+}
+
+
 /**
  *  Clears the currently set indicator from a range of text.
  *  Starting at @a pos, @a len characters long.
@@ -1370,3 +1413,86 @@ gint sci_word_end_position(ScintillaObject *sci, gint position, gboolean onlyWor
 	return SSM(sci, SCI_WORDENDPOSITION, position, onlyWordCharacters);
 }
 
+
+
+/* Creates an empty document with room for size bytes to be filled with
+ * sci_loader_add_data(), possibly from another thread, see SCI_CREATELOADER.
+ * A temporary widget is used as SCI_CREATELOADER resets the folding state of
+ * the widget it is sent to. */
+gpointer sci_loader_new(gsize size)
+{
+	ScintillaObject *sci = SCINTILLA(scintilla_new());
+	gpointer loader;
+
+	/* since we won't add the widget to any container, assume it's ownership */
+	g_object_ref_sink(sci);
+	loader = (gpointer) SSM(sci, SCI_CREATELOADER, size, 0);
+	g_object_unref(sci);
+
+	return loader;
+}
+
+
+gboolean sci_loader_add_data(gpointer loader, const gchar *data, gsize length)
+{
+	return scintilla_loader_add_data(loader, data, (gintptr) length) == SC_STATUS_OK;
+}
+
+
+void sci_loader_free(gpointer loader)
+{
+	scintilla_loader_release(loader);
+}
+
+
+/* Returns the document filled through loader, which must not be used any more. */
+gpointer sci_loader_get_document(gpointer loader)
+{
+	return scintilla_loader_convert_to_document(loader);
+}
+
+
+/* Creates a document showing length bytes of text without copying them, e.g. from
+ * a memory mapped file. text must stay valid until release is called with
+ * data, which happens when the document is freed or modified, in which case the
+ * text is copied. */
+gpointer sci_document_new_external(const gchar *text, gsize length, gboolean styled,
+		GDestroyNotify release, gpointer data)
+{
+	gint options = styled ? SC_DOCUMENTOPTION_DEFAULT : SC_DOCUMENTOPTION_STYLES_NONE;
+
+	return scintilla_document_new_external(text, (gintptr) length, options, release, data);
+}
+
+
+/* Creates a document with the text of sci's document without copying it. Both
+ * documents share the text until either is modified, which then copies it.
+ * Returns NULL on failure. */
+gpointer sci_document_clone(ScintillaObject *sci)
+{
+	return scintilla_document_clone((gpointer) SSM(sci, SCI_GETDOCPOINTER, 0, 0));
+}
+
+
+/* Creates an empty document like the one of a new editor. */
+gpointer sci_document_new(ScintillaObject *sci)
+{
+	return (gpointer) SSM(sci, SCI_CREATEDOCUMENT, 0, SC_DOCUMENTOPTION_DEFAULT);
+}
+
+
+/* Whether sci's document still shows text it has not copied from the application, e.g.
+ * from a memory mapped file. Text only shared with a cloned document doesn't count. */
+gboolean sci_has_external_text(ScintillaObject *sci)
+{
+	return scintilla_document_is_external((gpointer) SSM(sci, SCI_GETDOCPOINTER, 0, 0));
+}
+
+
+/* Replaces the document of sci, taking over the reference to document. */
+void sci_set_document(ScintillaObject *sci, gpointer document)
+{
+	SSM(sci, SCI_SETDOCPOINTER, 0, (sptr_t) document);
+	/* sci holds its own reference now */
+	SSM(sci, SCI_RELEASEDOCUMENT, 0, (sptr_t) document);
+}
@@ -121,6 +121,8 @@ gboolean			sci_can_undo				(ScintillaObject *sci);
 void 				sci_undo					(ScintillaObject *sci);
 void 				sci_redo					(ScintillaObject *sci);
 void 				sci_empty_undo_buffer		(ScintillaObject *sci);
+void				sci_set_undo_memory_limit	(ScintillaObject *sci, gsize bytes);
+gsize				sci_get_undo_memory			(ScintillaObject *sci);
 gboolean			sci_is_modified				(ScintillaObject *sci);
 
 void				sci_set_visible_eols		(ScintillaObject *sci, gboolean set);
@@ -154,12 +156,15 @@ gint				sci_get_position_from_xy	(ScintillaObject *sci, gint x, gint y, gboolean
 void 				sci_set_undo_collection		(ScintillaObject *sci, gboolean set);
 
 void 				sci_toggle_fold				(ScintillaObject *sci, gint line);
+void				sci_fold_all				(ScintillaObject *sci, gint action);
 gint				sci_get_fold_level			(ScintillaObject *sci, gint line);
 gint				sci_get_fold_parent			(ScintillaObject *sci, gint start_line);
 
 gboolean			sci_get_fold_expanded		(ScintillaObject *sci, gint line);
 
 void				sci_colourise				(ScintillaObject *sci, gint start, gint end);
+void				sci_set_idle_styling		(ScintillaObject *sci, gint mode);
+void				sci_set_layout_cache		(ScintillaObject *sci, gint mode);
 void				sci_clear_all				(ScintillaObject *sci);
 gint				sci_get_end_styled			(ScintillaObject *sci);
 void				sci_set_tab_width			(ScintillaObject *sci, gint width);
@@ -188,6 +193,7 @@ gint				sci_get_lines_selected		(ScintillaObject *sci);
 gint				sci_get_first_visible_line	(ScintillaObject *sci);
 
 void				sci_indicator_fill			(ScintillaObject *sci, gint pos, gint len);
+void				sci_indicator_fill_ranges	(ScintillaObject *sci, const Sci_Position *ranges, guint count);
 
 void				sci_select_all				(ScintillaObject *sci);
 gint				sci_get_line_indent_position(ScintillaObject *sci, gint line);
@@ -217,6 +223,17 @@ void				sci_move_selected_lines_up      (ScintillaObject *sci);
 
 void				sci_set_font_fractional		(ScintillaObject *sci, gint style, const gchar *font, gdouble size);
 
+gpointer			sci_loader_new				(gsize size);
+gboolean			sci_loader_add_data			(gpointer loader, const gchar *data, gsize length);
+void				sci_loader_free				(gpointer loader);
+gpointer			sci_loader_get_document		(gpointer loader);
+gpointer			sci_document_new_external	(const gchar *text, gsize length, gboolean styled,
+												 GDestroyNotify release, gpointer data);
+gpointer			sci_document_clone			(ScintillaObject *sci);
+gpointer			sci_document_new			(ScintillaObject *sci);
+gboolean			sci_has_external_text		(ScintillaObject *sci);
+void				sci_set_document			(ScintillaObject *sci, gpointer document);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
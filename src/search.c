@@ -1231,6 +1231,7 @@ gint search_mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlag
 	gint count = 0;
 	struct Sci_TextToFind ttf;
 	GSList *match, *matches;
+	GArray *ranges;
 
 	g_return_val_if_fail(DOC_VALID(doc), 0);
 
@@ -1245,18 +1246,27 @@ gint search_mark_all(GeanyDocument *doc, const gchar *search_text, GeanyFindFlag
 	ttf.lpstrText = (gchar *)search_text;
 
 	matches = find_range(doc->editor->sci, flags, &ttf);
+	ranges = g_array_new(FALSE, FALSE, sizeof(gint));
 	foreach_slist (match, matches)
 	{
 		GeanyMatchInfo *info = match->data;
 
 		if (info->end != info->start)
-			editor_indicator_set_on_range(doc->editor, GEANY_INDICATOR_SEARCH, info->start, info->end);
+		{
+			g_array_append_val(ranges, info->start);
+			g_array_append_val(ranges, info->end);
+		}
 		count++;
 
 		geany_match_info_free(info);
 	}
 	g_slist_free(matches);
 
+	/* set all indicators at once, filling them one by one is slow for many matches */
+	editor_indicator_set_on_ranges(doc->editor, GEANY_INDICATOR_SEARCH,
+		(const gint *) ranges->data, ranges->len / 2);
+	g_array_free(ranges, TRUE);
+
 	return count;
 }
 
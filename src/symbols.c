@@ -119,6 +119,8 @@ static void load_user_tags(GeanyFiletypeID ft_id);
 
 /* get the tags_ignore list, exported by tagmanager's geany.c */
 extern gchar **c_tags_ignore;
+/* drops ctags' index of c_tags_ignore, needed whenever it changes */
+extern void resetIgnoreTokens(void);
 
 /* ignore certain tokens when parsing C-like syntax.
  * Also works for reloading. */
@@ -134,6 +136,7 @@ static void load_c_ignore_tags(void)
 
 		g_strfreev(c_tags_ignore);
 		c_tags_ignore = g_strsplit_set(content, " \n\r", -1);
+		resetIgnoreTokens();
 		g_free(content);
 	}
 	g_free(path);
@@ -2687,6 +2690,8 @@ void symbols_finalize(void)
 	guint i;
 
 	g_strfreev(c_tags_ignore);
+	c_tags_ignore = NULL;
+	resetIgnoreTokens();
 
 	for (i = 0; i < G_N_ELEMENTS(symbols_icons); i++)
 	{
@@ -0,0 +1,344 @@
+/*
+ *      geany_tags.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * geany-tags: headless generator of global tags files.
+ *
+ * Walks the given files and directories, parses every file of the requested
+ * language and writes a sorted, deduplicated tags file in the same format as
+ * "geany -g", without needing the GUI. Since ctags keeps its parser state in
+ * global variables, parsing is spread over worker processes rather than
+ * threads; each worker writes its tags to a temporary file which is merged
+ * by the parent.
+ */
+
+#include "general.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_UNIX
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+#include "tm_workspace.h"
+#include "tm_source_file.h"
+#include "tm_tag.h"
+#include "tm_parser.h"
+#include "ctags-api.h"
+
+
+/* the ignore list of the C-like parsers, in ctags' options.c */
+extern gchar **c_tags_ignore;
+extern void resetIgnoreTokens(void);
+
+/* keep in sync with global_tags_sort_attrs in tm_workspace.c */
+static TMTagAttrType global_tags_sort_attrs[] =
+{
+	tm_tag_attr_name_t,
+	tm_tag_attr_type_t, tm_tag_attr_scope_t, tm_tag_attr_arglist_t, 0
+};
+
+static gchar *opt_config = NULL;
+static gint opt_jobs = 0;
+static gchar *opt_lang = NULL;
+static gboolean opt_verbose = FALSE;
+
+static GOptionEntry entries[] =
+{
+	{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &opt_config, "Read ignore.tags from DIR (default: Geany's configuration directory)", "DIR" },
+	{ "jobs", 'j', 0, G_OPTION_ARG_INT, &opt_jobs, "Number of parsing processes (default: number of processors)", "N" },
+	{ "lang", 'l', 0, G_OPTION_ARG_STRING, &opt_lang, "Parse files as LANG (default: guessed from TAGS_FILE)", "LANG" },
+	{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &opt_verbose, "Print the names of parsed files", NULL },
+	{ NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+
+
+/* Loads ignore.tags like "geany -g" does, so both generate the same tags. */
+static void load_c_ignore_tags(void)
+{
+	gchar *path;
+	gchar *content;
+
+	if (opt_config)
+		path = g_build_filename(opt_config, "ignore.tags", NULL);
+	else
+		path = g_build_filename(g_get_user_config_dir(), "geany", "ignore.tags", NULL);
+
+	if (g_file_get_contents(path, &content, NULL, NULL))
+	{
+		/* historically we ignore the glib _DECLS for tag generation */
+		gchar *all = g_strconcat("G_BEGIN_DECLS G_END_DECLS\n", content, NULL);
+
+		g_strfreev(c_tags_ignore);
+		c_tags_ignore = g_strsplit_set(all, " \n\r", -1);
+		resetIgnoreTokens();
+		g_free(all);
+		g_free(content);
+	}
+	g_free(path);
+}
+
+
+/* Adds path to files if it is a file of lang, or all such files below it if
+ * it is a directory. Files given explicitly are always parsed. Links to
+ * directories are only followed when given explicitly, as one pointing to a
+ * parent directory would make the walk endless. */
+static void collect_files(const gchar *path, TMParserType lang, gboolean explicit,
+	GPtrArray *files)
+{
+	if (g_file_test(path, G_FILE_TEST_IS_DIR))
+	{
+		GDir *dir;
+		const gchar *name;
+
+		if (!explicit && g_file_test(path, G_FILE_TEST_IS_SYMLINK))
+		{
+			if (opt_verbose)
+				g_printerr("geany-tags: %s: skipping link to directory\n", path);
+			return;
+		}
+
+		dir = g_dir_open(path, 0, NULL);
+		if (!dir)
+			return;
+
+		while ((name = g_dir_read_name(dir)) != NULL)
+		{
+			gchar *child;
+
+			/* skip hidden files and VCS directories */
+			if (name[0] == '.')
+				continue;
+
+			child = g_build_filename(path, name, NULL);
+			collect_files(child, lang, FALSE, files);
+			g_free(child);
+		}
+		g_dir_close(dir);
+	}
+	else if (g_file_test(path, G_FILE_TEST_IS_REGULAR))
+	{
+		if (explicit || tm_parser_langs_compatible(lang, ctagsGetFileLang(path)))
+			g_ptr_array_add(files, g_strdup(path));
+	}
+	else if (explicit)
+		g_printerr("geany-tags: %s: No such file or directory\n", path);
+}
+
+
+/* Parses every step'th file of files starting with first and returns the
+ * sorted and deduplicated tags. */
+static GPtrArray *parse_files(GPtrArray *files, guint first, guint step, TMParserType lang)
+{
+	const gchar *lang_name = tm_source_file_get_lang_name(lang);
+	GPtrArray *tags = g_ptr_array_new();
+	guint i, j;
+
+	for (i = first; i < files->len; i += step)
+	{
+		TMSourceFile *source_file = tm_source_file_new(files->pdata[i], lang_name);
+
+		if (!source_file)
+			continue;
+
+		if (opt_verbose)
+			g_print("%s\n", (gchar *) files->pdata[i]);
+
+		tm_source_file_parse(source_file, NULL, 0, FALSE);
+		for (j = 0; j < source_file->tags_array->len; j++)
+			g_ptr_array_add(tags, tm_tag_ref(source_file->tags_array->pdata[j]));
+		tm_source_file_free(source_file);
+	}
+
+	tm_tags_sort(tags, global_tags_sort_attrs, TRUE, TRUE);
+	return tags;
+}
+
+
+#ifdef G_OS_UNIX
+/* Forks jobs workers, each parsing a share of files into a temporary tags
+ * file, and merges their results. Returns NULL if any of the workers failed. */
+static GPtrArray *parse_files_parallel(GPtrArray *files, guint jobs, TMParserType lang)
+{
+	GPtrArray *tags = g_ptr_array_new();
+	gchar **temp_files = g_new0(gchar *, jobs + 1);
+	pid_t *pids = g_new0(pid_t, jobs);
+	gboolean ok = TRUE;
+	guint i, j;
+
+	/* don't let the workers inherit unflushed output */
+	fflush(NULL);
+
+	for (i = 0; i < jobs && ok; i++)
+	{
+		gint fd = g_file_open_tmp("geany-tags-XXXXXX", &temp_files[i], NULL);
+
+		if (fd < 0)
+		{
+			ok = FALSE;
+			break;
+		}
+		close(fd);
+
+		pids[i] = fork();
+		if (pids[i] < 0)
+			ok = FALSE;
+		else if (pids[i] == 0)
+		{
+			GPtrArray *worker_tags = parse_files(files, i, jobs, lang);
+			gboolean written = tm_source_file_write_tags_file(temp_files[i], worker_tags);
+
+			fflush(NULL);
+			_exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	for (j = 0; j < i; j++)
+	{
+		gint status;
+
+		if (pids[j] <= 0 || waitpid(pids[j], &status, 0) < 0 ||
+			!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+		{
+			ok = FALSE;
+		}
+	}
+
+	for (j = 0; j < jobs; j++)
+	{
+		GPtrArray *worker_tags;
+
+		if (!temp_files[j])
+			continue;
+
+		worker_tags = ok ? tm_source_file_read_tags_file(temp_files[j], lang) : NULL;
+		if (worker_tags)
+		{
+			for (i = 0; i < worker_tags->len; i++)
+				g_ptr_array_add(tags, worker_tags->pdata[i]);
+			g_ptr_array_free(worker_tags, TRUE);
+		}
+		g_unlink(temp_files[j]);
+	}
+
+	g_strfreev(temp_files);
+	g_free(pids);
+
+	if (!ok)
+	{
+		tm_tags_array_free(tags, TRUE);
+		return NULL;
+	}
+
+	tm_tags_sort(tags, global_tags_sort_attrs, TRUE, TRUE);
+	return tags;
+}
+#endif
+
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	GPtrArray *files;
+	GPtrArray *tags;
+	TMParserType lang;
+	const gchar *tags_file;
+	gboolean ok;
+	gint i;
+
+	context = g_option_context_new("TAGS_FILE PATH... - generate a Geany global tags file");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		g_printerr("geany-tags: %s\n", error->message);
+		g_error_free(error);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(context);
+
+	if (argc < 3)
+	{
+		g_printerr("Usage: geany-tags [-c DIR] [-j N] [-l LANG] TAGS_FILE PATH...\n");
+		return EXIT_FAILURE;
+	}
+	tags_file = argv[1];
+
+	/* initializes ctags */
+	tm_get_workspace();
+
+	if (opt_lang)
+		lang = tm_source_file_get_named_lang(opt_lang);
+	else
+	{
+		/* like "geany -g", use the extension before .tags, e.g. gtk3.c.tags */
+		gchar *name = g_strdup(tags_file);
+
+		if (g_str_has_suffix(name, ".tags"))
+			name[strlen(name) - strlen(".tags")] = '\0';
+		lang = ctagsGetFileLang(name);
+		g_free(name);
+	}
+	if (lang == TM_PARSER_NONE)
+	{
+		g_printerr("geany-tags: unknown language, use --lang\n");
+		return EXIT_FAILURE;
+	}
+
+	/* load ignore list for C/C++ parser */
+	if (lang == TM_PARSER_C || lang == TM_PARSER_CPP)
+		load_c_ignore_tags();
+
+	files = g_ptr_array_new_with_free_func(g_free);
+	for (i = 2; i < argc; i++)
+		collect_files(argv[i], lang, TRUE, files);
+
+	if (opt_jobs <= 0)
+		opt_jobs = (gint) g_get_num_processors();
+	opt_jobs = MIN((guint) opt_jobs, MAX(files->len, 1));
+
+#ifdef G_OS_UNIX
+	if (opt_jobs > 1)
+		tags = parse_files_parallel(files, opt_jobs, lang);
+	else
+#endif
+		tags = parse_files(files, 0, 1, lang);
+
+	ok = tags != NULL && tm_source_file_write_tags_file(tags_file, tags);
+	if (!ok)
+		g_printerr("geany-tags: failed to create %s\n", tags_file);
+	else if (opt_verbose)
+		g_print("%u tag(s) from %u file(s) written to %s\n", tags->len, files->len, tags_file);
+
+	if (tags)
+		tm_tags_array_free(tags, TRUE);
+	g_ptr_array_free(files, TRUE);
+	g_strfreev(c_tags_ignore);
+	c_tags_ignore = NULL;
+	resetIgnoreTokens();
+	tm_workspace_free();
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -41,6 +41,11 @@ typedef struct
 } TMSourceFilePriv;
 
 
+/* stdio buffer size used for reading and writing tags files */
+#define TAGS_FILE_BUFFER_SIZE (1024 * 1024)
+/* minimum number of bytes to read at once when reading a line */
+#define TAGS_FILE_READ_CHUNK 256
+
 typedef enum {
 	TM_FILE_FORMAT_TAGMANAGER,
 	TM_FILE_FORMAT_PIPE,
@@ -221,22 +226,21 @@ static gboolean init_tag(TMTag *tag, TMSourceFile *file, const ctagsTag *tag_ent
 }
 
 /*
- Initializes an already malloc()ed TMTag structure by reading a tag entry
- line from a file. The structure should be allocated beforehand.
+ Initializes an already malloc()ed TMTag structure from a tag entry line
+ read from a file. The structure should be allocated beforehand.
  @param tag The TMTag structure to populate
  @param file The TMSourceFile struct (assigned to the file member)
- @param fp FILE pointer from where the tag line is read
+ @param buf The tag line, which is modified temporarily while parsing
  @return TRUE on success, FALSE on FAILURE
 */
-static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp)
+static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, guchar *buf)
 {
-	guchar buf[BUFSIZ];
 	guchar *start, *end;
 	gboolean status;
 	guchar changed_char = TA_NAME;
 
 	tag->refcount = 1;
-	if ((NULL == fgets((gchar*)buf, BUFSIZ, fp)) || ('\0' == *buf))
+	if ('\0' == *buf)
 		return FALSE;
 	for (start = end = buf, status = TRUE; (TRUE == status); start = end, ++ end)
 	{
@@ -310,15 +314,14 @@ static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp)
 
 /* alternative parser for Pascal and LaTeX global tags files with the following format
  * tagname|return value|arglist|description\n */
-static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *fp)
+static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, guchar *buf)
 {
-	guchar buf[BUFSIZ];
 	guchar *start, *end;
 	gboolean status;
 	/*guchar changed_char = TA_NAME;*/
 
 	tag->refcount = 1;
-	if ((NULL == fgets((gchar*)buf, BUFSIZ, fp)) || ('\0' == *buf))
+	if ('\0' == *buf)
 		return FALSE;
 	{
 		gchar **fields;
@@ -355,19 +358,14 @@ static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *fp)
 /*
  CTags tag file format (http://ctags.sourceforge.net/FORMAT)
 */
-static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *fp, TMParserType lang)
+static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, gchar *buf, TMParserType lang)
 {
-	gchar buf[BUFSIZ];
 	gchar *p, *tab;
 
 	tag->refcount = 1;
 	tag->type = tm_tag_function_t; /* default type is function if no kind is specified */
-	do
-	{
-		if ((NULL == fgets(buf, BUFSIZ, fp)) || ('\0' == *buf))
-			return FALSE;
-	}
-	while (strncmp(buf, "!_TAG_", 6) == 0); /* skip !_TAG_ lines */
+	if ('\0' == *buf)
+		return FALSE;
 
 	p = buf;
 
@@ -467,21 +465,58 @@ static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *f
 	return TRUE;
 }
 
-static TMTag *new_tag_from_tags_file(TMSourceFile *file, FILE *fp, TMParserType mode, TMFileFormat format)
+/*
+ Reads a whole line from fp into line, including the trailing newline if any.
+ Lines can be of any length and the memory of line is reused across calls, so
+ once it has grown to the longest line no further allocation happens.
+ @return TRUE if anything was read, FALSE at the end of the file or on error.
+*/
+static gboolean read_tags_file_line(FILE *fp, GString *line)
+{
+	gsize len = 0;
+
+	for (;;)
+	{
+		gsize n;
+
+		/* read directly into the free space of line, growing it if needed */
+		g_string_set_size(line, MAX(line->allocated_len - 1, len + TAGS_FILE_READ_CHUNK));
+		if (NULL == fgets(line->str + len, (int) MIN(line->len - len + 1, G_MAXINT), fp))
+			break;
+		n = strlen(line->str + len);
+		len += n;
+		if (n == 0 || line->str[len - 1] == '\n')
+			break;
+	}
+	g_string_truncate(line, len);
+
+	return len > 0;
+}
+
+static TMTag *new_tag_from_tags_file(TMSourceFile *file, FILE *fp, GString *line,
+	TMParserType mode, TMFileFormat format)
 {
-	TMTag *tag = tm_tag_new();
+	TMTag *tag;
 	gboolean result = FALSE;
 
+	do
+	{
+		if (!read_tags_file_line(fp, line))
+			return NULL;
+	}
+	while (format == TM_FILE_FORMAT_CTAGS && strncmp(line->str, "!_TAG_", 6) == 0); /* skip !_TAG_ lines */
+
+	tag = tm_tag_new();
 	switch (format)
 	{
 		case TM_FILE_FORMAT_TAGMANAGER:
-			result = init_tag_from_file(tag, file, fp);
+			result = init_tag_from_file(tag, file, (guchar *) line->str);
 			break;
 		case TM_FILE_FORMAT_PIPE:
-			result = init_tag_from_file_alt(tag, file, fp);
+			result = init_tag_from_file_alt(tag, file, (guchar *) line->str);
 			break;
 		case TM_FILE_FORMAT_CTAGS:
-			result = init_tag_from_file_ctags(tag, file, fp, mode);
+			result = init_tag_from_file_ctags(tag, file, line->str, mode);
 			break;
 	}
 
@@ -494,74 +529,141 @@ static TMTag *new_tag_from_tags_file(TMSourceFile *file, FILE *fp, TMParserType
 	return tag;
 }
 
+/* Appends the decimal representation of value to str, like "%ld" would but
+ * without going through the printf machinery for every field. */
+static void append_number(GString *str, glong value)
+{
+	gchar buf[24];
+	gchar *p = buf + sizeof buf;
+	gulong v = value < 0 ? - (gulong) value : (gulong) value;
+
+	do
+	{
+		*--p = (gchar) ('0' + v % 10);
+		v /= 10;
+	}
+	while (v != 0);
+	if (value < 0)
+		*--p = '-';
+
+	g_string_append_len(str, p, buf + sizeof buf - p);
+}
+
 /*
- Writes tag information to the given FILE *.
+ Formats the tag information as a tags file line.
  @param tag The tag information to write.
- @param file FILE pointer to which the tag information is written.
+ @param line String to which the tag line is appended.
  @param attrs Attributes to be written (bitmask).
- @return TRUE on success, FALSE on failure.
 */
-static gboolean write_tag(TMTag *tag, FILE *fp, TMTagAttrType attrs)
+static void format_tag(TMTag *tag, GString *line, TMTagAttrType attrs)
 {
-	fprintf(fp, "%s", tag->name);
+	g_string_append(line, tag->name);
 	if (attrs & tm_tag_attr_type_t)
-		fprintf(fp, "%c%d", TA_TYPE, tag->type);
+	{
+		g_string_append_c(line, TA_TYPE);
+		append_number(line, tag->type);
+	}
 	if ((attrs & tm_tag_attr_arglist_t) && (NULL != tag->arglist))
-		fprintf(fp, "%c%s", TA_ARGLIST, tag->arglist);
+	{
+		g_string_append_c(line, TA_ARGLIST);
+		g_string_append(line, tag->arglist);
+	}
 	if (attrs & tm_tag_attr_line_t)
-		fprintf(fp, "%c%ld", TA_LINE, tag->line);
+	{
+		g_string_append_c(line, TA_LINE);
+		append_number(line, (glong) tag->line);
+	}
 	if (attrs & tm_tag_attr_local_t)
-		fprintf(fp, "%c%d", TA_LOCAL, tag->local);
+	{
+		g_string_append_c(line, TA_LOCAL);
+		append_number(line, tag->local);
+	}
 	if ((attrs & tm_tag_attr_scope_t) && (NULL != tag->scope))
-		fprintf(fp, "%c%s", TA_SCOPE, tag->scope);
+	{
+		g_string_append_c(line, TA_SCOPE);
+		g_string_append(line, tag->scope);
+	}
 	if ((attrs & tm_tag_attr_inheritance_t) && (NULL != tag->inheritance))
-		fprintf(fp, "%c%s", TA_INHERITS, tag->inheritance);
+	{
+		g_string_append_c(line, TA_INHERITS);
+		g_string_append(line, tag->inheritance);
+	}
 	if (attrs & tm_tag_attr_pointer_t)
-		fprintf(fp, "%c%d", TA_POINTER, tag->pointerOrder);
+	{
+		g_string_append_c(line, TA_POINTER);
+		append_number(line, (gint) tag->pointerOrder);
+	}
 	if ((attrs & tm_tag_attr_vartype_t) && (NULL != tag->var_type))
-		fprintf(fp, "%c%s", TA_VARTYPE, tag->var_type);
+	{
+		g_string_append_c(line, TA_VARTYPE);
+		g_string_append(line, tag->var_type);
+	}
 	if ((attrs & tm_tag_attr_access_t) && (TAG_ACCESS_UNKNOWN != tag->access))
-		fprintf(fp, "%c%c", TA_ACCESS, tag->access);
+	{
+		g_string_append_c(line, TA_ACCESS);
+		g_string_append_c(line, tag->access);
+	}
 	if ((attrs & tm_tag_attr_impl_t) && (TAG_IMPL_UNKNOWN != tag->impl))
-		fprintf(fp, "%c%c", TA_IMPL, tag->impl);
+	{
+		g_string_append_c(line, TA_IMPL);
+		g_string_append_c(line, tag->impl);
+	}
+	g_string_append_c(line, '\n');
+}
 
-	if (fprintf(fp, "\n"))
-		return TRUE;
-	else
-		return FALSE;
+/* Opens a tags file with a large stdio buffer, which has to be freed with
+ * g_free() after closing the file. */
+static FILE *open_tags_file(const gchar *tags_file, const gchar *mode, gchar **buffer)
+{
+	FILE *fp = g_fopen(tags_file, mode);
+
+	*buffer = NULL;
+	if (fp)
+	{
+		*buffer = g_malloc(TAGS_FILE_BUFFER_SIZE);
+		setvbuf(fp, *buffer, _IOFBF, TAGS_FILE_BUFFER_SIZE);
+	}
+	return fp;
 }
 
 GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode)
 {
-	guchar buf[BUFSIZ];
+	gchar *buffer;
+	GString *line;
 	FILE *fp;
 	GPtrArray *file_tags;
 	TMTag *tag;
 	TMFileFormat format = TM_FILE_FORMAT_TAGMANAGER;
 
-	if (NULL == (fp = g_fopen(tags_file, "r")))
+	if (NULL == (fp = open_tags_file(tags_file, "r", &buffer)))
 		return NULL;
-	if ((NULL == fgets((gchar*) buf, BUFSIZ, fp)) || ('\0' == *buf))
+	line = g_string_sized_new(BUFSIZ);
+	if (!read_tags_file_line(fp, line) || ('\0' == *line->str))
 	{
 		fclose(fp);
+		g_free(buffer);
+		g_string_free(line, TRUE);
 		return NULL; /* early out on error */
 	}
 	else
 	{	/* We read (and discard) the first line for the format specification. */
-		if (buf[0] == '#' && strstr((gchar*) buf, "format=pipe") != NULL)
+		const gchar *buf = line->str;
+
+		if (buf[0] == '#' && strstr(buf, "format=pipe") != NULL)
 			format = TM_FILE_FORMAT_PIPE;
-		else if (buf[0] == '#' && strstr((gchar*) buf, "format=tagmanager") != NULL)
+		else if (buf[0] == '#' && strstr(buf, "format=tagmanager") != NULL)
 			format = TM_FILE_FORMAT_TAGMANAGER;
-		else if (buf[0] == '#' && strstr((gchar*) buf, "format=ctags") != NULL)
+		else if (buf[0] == '#' && strstr(buf, "format=ctags") != NULL)
 			format = TM_FILE_FORMAT_CTAGS;
-		else if (strncmp((gchar*) buf, "!_TAG_", 6) == 0)
+		else if (strncmp(buf, "!_TAG_", 6) == 0)
 			format = TM_FILE_FORMAT_CTAGS;
 		else
 		{	/* We didn't find a valid format specification, so we try to auto-detect the format
 			 * by counting the pipe characters on the first line and asumme pipe format when
 			 * we find more than one pipe on the line. */
-			guint i, pipe_cnt = 0, tab_cnt = 0;
-			for (i = 0; i < BUFSIZ && buf[i] != '\0' && pipe_cnt < 2; i++)
+			guint pipe_cnt = 0, tab_cnt = 0;
+			gsize i;
+			for (i = 0; i < line->len && buf[i] != '\0' && pipe_cnt < 2; i++)
 			{
 				if (buf[i] == '|')
 					pipe_cnt++;
@@ -578,9 +680,11 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 	}
 
 	file_tags = g_ptr_array_new();
-	while (NULL != (tag = new_tag_from_tags_file(NULL, fp, mode, format)))
+	while (NULL != (tag = new_tag_from_tags_file(NULL, fp, line, mode, format)))
 		g_ptr_array_add(file_tags, tag);
 	fclose(fp);
+	g_free(buffer);
+	g_string_free(line, TRUE);
 
 	return file_tags;
 }
@@ -588,28 +692,35 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_array)
 {
 	guint i;
+	gchar *buffer;
+	GString *line;
 	FILE *fp;
 	gboolean ret = TRUE;
 
 	g_return_val_if_fail(tags_array && tags_file, FALSE);
 
-	fp = g_fopen(tags_file, "w");
+	fp = open_tags_file(tags_file, "w", &buffer);
 	if (!fp)
 		return FALSE;
 
-	fprintf(fp, "# format=tagmanager\n");
-	for (i = 0; i < tags_array->len; i++)
+	ret = fputs("# format=tagmanager\n", fp) >= 0;
+	/* every line is formatted into the same string and written at once */
+	line = g_string_sized_new(BUFSIZ);
+	for (i = 0; ret && i < tags_array->len; i++)
 	{
 		TMTag *tag = TM_TAG(tags_array->pdata[i]);
 
-		ret = write_tag(tag, fp, tm_tag_attr_type_t
+		format_tag(tag, line, tm_tag_attr_type_t
 		  | tm_tag_attr_scope_t | tm_tag_attr_arglist_t | tm_tag_attr_vartype_t
 		  | tm_tag_attr_pointer_t);
 
-		if (!ret)
-			break;
+		ret = fwrite(line->str, 1, line->len, fp) == line->len;
+		g_string_truncate(line, 0);
 	}
-	fclose(fp);
+	if (fclose(fp) != 0)
+		ret = FALSE;
+	g_free(buffer);
+	g_string_free(line, TRUE);
 
 	return ret;
 }
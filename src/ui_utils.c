@@ -2860,6 +2860,13 @@ void ui_progress_bar_stop(void)
 }
 
 
+/* Whether ui_progress_bar_start() is pulsing the progress bar, e.g. for a build */
+gboolean ui_progress_bar_is_running(void)
+{
+	return progress_bar_timer_id != 0;
+}
+
+
 static gint compare_menu_item_labels(gconstpointer a, gconstpointer b)
 {
 	GtkMenuItem *item_a = GTK_MENU_ITEM(a);
@@ -360,6 +360,8 @@ gint ui_encodings_combo_box_get_active_encoding(GtkComboBox *combo);
 
 gboolean ui_encodings_combo_box_set_active_encoding(GtkComboBox *combo, gint enc);
 
+gboolean ui_progress_bar_is_running(void);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
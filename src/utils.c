@@ -98,53 +98,75 @@ void utils_open_browser(const gchar *uri)
 }
 
 
-/* taken from anjuta, to determine the EOL mode of the file */
-gint utils_get_line_endings(const gchar* buffer, gsize size)
+/* Counts the line endings in buffer, which can be passed in several pieces.
+ * counts has to be zero-initialized before the first call.
+ * taken from anjuta, to determine the EOL mode of the file */
+GEANY_EXPORT_SYMBOL
+void utils_count_line_endings(GeanyLineEndingCounts *counts, const gchar *buffer, gsize size)
 {
-	gsize i;
-	guint cr, lf, crlf, max_mode;
-	gint mode;
+	gsize i = 0;
 
-	cr = lf = crlf = 0;
+	if (counts->pending_cr && size > 0)
+	{
+		/* CR at the end of the previous piece */
+		if (buffer[0] != 0x0a)
+			counts->cr++;
+		else
+			counts->crlf++;
+		counts->pending_cr = FALSE;
+		i++;
+	}
 
-	for (i = 0; i < size ; i++)
+	for (; i < size ; i++)
 	{
 		if (buffer[i] == 0x0a)
 		{
 			/* LF */
-			lf++;
+			counts->lf++;
 		}
 		else if (buffer[i] == 0x0d)
 		{
 			if (i >= (size - 1))
 			{
-				/* Last char, CR */
-				cr++;
+				/* Last char, CR or CRLF depending on the next piece */
+				counts->pending_cr = TRUE;
 			}
 			else
 			{
 				if (buffer[i + 1] != 0x0a)
 				{
 					/* CR */
-					cr++;
+					counts->cr++;
 				}
 				else
 				{
 					/* CRLF */
-					crlf++;
+					counts->crlf++;
 				}
 				i++;
 			}
 		}
 	}
+}
+
+
+/* Returns the EOL mode for line endings counted by utils_count_line_endings() */
+GEANY_EXPORT_SYMBOL
+gint utils_get_line_endings_from_counts(const GeanyLineEndingCounts *counts)
+{
+	guint cr, max_mode;
+	gint mode;
+
+	/* a CR at the very end */
+	cr = counts->cr + (counts->pending_cr ? 1 : 0);
 
 	/* Vote for the maximum */
 	mode = SC_EOL_LF;
-	max_mode = lf;
-	if (crlf > max_mode)
+	max_mode = counts->lf;
+	if (counts->crlf > max_mode)
 	{
 		mode = SC_EOL_CRLF;
-		max_mode = crlf;
+		max_mode = counts->crlf;
 	}
 	if (cr > max_mode)
 	{
@@ -156,6 +178,17 @@ gint utils_get_line_endings(const gchar* buffer, gsize size)
 }
 
 
+/* determines the EOL mode of the file contents in buffer */
+GEANY_EXPORT_SYMBOL
+gint utils_get_line_endings(const gchar* buffer, gsize size)
+{
+	GeanyLineEndingCounts counts = { 0 };
+
+	utils_count_line_endings(&counts, buffer, size);
+	return utils_get_line_endings_from_counts(&counts);
+}
+
+
 gboolean utils_isbrace(gchar c, gboolean include_angles)
 {
 	switch (c)
@@ -229,6 +229,17 @@ typedef enum
 } GeanyResourceDirType;
 
 
+typedef struct
+{
+	guint cr, lf, crlf;
+	gboolean pending_cr;	/* whether the last counted character was a CR */
+} GeanyLineEndingCounts;
+
+
+void utils_count_line_endings(GeanyLineEndingCounts *counts, const gchar *buffer, gsize size);
+
+gint utils_get_line_endings_from_counts(const GeanyLineEndingCounts *counts);
+
 gint utils_get_line_endings(const gchar* buffer, gsize size);
 
 gboolean utils_isbrace(gchar c, gboolean include_angles);
@@ -0,0 +1,114 @@
+/*
+ *      bench_ignore_tokens.cxx - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Times looking up the identifiers read by the C-like ctags parsers in the ignore.tags
+ * list. Build it with "make -C tests bench_ignore_tokens" and run it on two revisions
+ * to compare them; see tests/Makefile.am.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "bench_utils.h"
+
+/* Declared like src/symbols.c does, as the ctags headers are not meant for C++ */
+extern "C" {
+extern char **c_tags_ignore;
+bool isIgnoreToken(const char *const name, bool *const pIgnoreParens, const char **const replacement);
+}
+
+namespace {
+
+const int entries = 2000;
+const int lookups = 200000;
+
+// A list the size of one generated from a large library's headers, using all four forms
+// of entry, with a few prefix wildcards at its end as they are looked at for every name.
+std::vector<std::string> MakeIgnoreList() {
+	std::vector<std::string> list;
+	for (int i = 0; i < entries; i++) {
+		char entry[64];
+		if (i % 7 == 0)
+			std::snprintf(entry, sizeof(entry), "LIB_ALIAS_%d=int", i);
+		else if (i % 5 == 0)
+			std::snprintf(entry, sizeof(entry), "LIB_ATTRIBUTE_%d+", i);
+		else
+			std::snprintf(entry, sizeof(entry), "LIB_DECLS_%d", i);
+		list.push_back(entry);
+	}
+	list.push_back("G_GNUC_*");
+	list.push_back("GLIB_AVAILABLE_*");
+	list.push_back("_LIB_INTERNAL_*");
+	return list;
+}
+
+// Names as read from source code: mostly not in the list, the rest split between exact
+// entries and names matching a wildcard.
+std::vector<std::string> MakeNames() {
+	static const char *const words[] = { "buffer", "count", "get", "set", "node", "list", "free", "new" };
+	BenchRandom random;
+	std::vector<std::string> names;
+	for (int i = 0; i < 10000; i++) {
+		char name[64];
+		const unsigned int kind = random.Next(10);
+		const unsigned int n = random.Next(entries);
+		if (kind < 2)
+			std::snprintf(name, sizeof(name), "%s%u", (n % 7 == 0) ? "LIB_ALIAS_" :
+				(n % 5 == 0) ? "LIB_ATTRIBUTE_" : "LIB_DECLS_", n);
+		else if (kind < 3)
+			std::snprintf(name, sizeof(name), "G_GNUC_%s", words[random.Next(8)]);
+		else
+			std::snprintf(name, sizeof(name), "%s_%s%u", words[random.Next(8)], words[random.Next(8)], n);
+		names.push_back(name);
+	}
+	return names;
+}
+
+int Lookup(const std::vector<std::string> &names) {
+	int ignored = 0;
+	for (int i = 0; i < lookups; i++) {
+		bool ignoreParens = false;
+		const char *replacement = nullptr;
+		if (isIgnoreToken(names[i % names.size()].c_str(), &ignoreParens, &replacement))
+			ignored++;
+	}
+	return ignored;
+}
+
+}
+
+int main() {
+	std::vector<std::string> list = MakeIgnoreList();
+	std::vector<char *> ignore;
+	for (std::string &entry : list)
+		ignore.push_back(&entry[0]);
+	ignore.push_back(nullptr);
+	c_tags_ignore = ignore.data();
+
+	const std::vector<std::string> names = MakeNames();
+	int ignored = 0;
+	BENCH_TIME(ignored = Lookup(names),
+		"look up %d names in %zu entries (%d ignored)", lookups, list.size(), ignored);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/*
+ *      bench_line_ends.cxx - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Times finding the line ends of text inserted into Scintilla's CellBuffer, as done
+ * when opening a file. Build it with "make -C tests bench_line_ends" and run it on
+ * two revisions to compare them; see tests/Makefile.am.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+
+#include "Platform.h"
+#include "Scintilla.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "CellBuffer.h"
+
+#include "bench_utils.h"
+
+using namespace Scintilla;
+
+namespace {
+
+const size_t textSize = 200 * 1024 * 1024;
+
+// Lines of 1 to 140 characters, which gives about 2.8 million lines. mixed uses CR
+// LF, CR, LF and the UTF-8 line ends NEL, LS and PS instead of only LF.
+std::string MakeText(bool mixed) {
+	static const char *const lineEnds[] = { "\r\n", "\r", "\n", "\xc2\x85", "\xe2\x80\xa8", "\xe2\x80\xa9" };
+	BenchRandom random;
+	std::string text;
+	text.reserve(textSize + 200);
+	while (text.size() < textSize) {
+		const unsigned int length = 1 + random.Next(140);
+		for (unsigned int i = 0; i < length; i++)
+			text += static_cast<char>('!' + random.Next(94));
+		text += mixed ? lineEnds[random.Next(6)] : "\n";
+	}
+	return text;
+}
+
+Sci::Line Insert(const std::string &text, int utf8LineEnds) {
+	CellBuffer cb(false, true);
+	cb.SetLineEndTypes(utf8LineEnds);
+	bool startSequence = false;
+	cb.InsertString(0, text.c_str(), text.length(), startSequence);
+	return cb.Lines();
+}
+
+}
+
+int main() {
+	for (int mixed = 0; mixed <= 1; mixed++) {
+		const std::string text = MakeText(mixed != 0);
+		const char *kind = mixed ? "mixed line ends" : "LF line ends";
+		Sci::Line lines = 0;
+
+		BENCH_TIME(lines = Insert(text, SC_LINE_END_TYPE_DEFAULT),
+			"insert %zu MB, %s (%ld lines)", text.length() >> 20, kind, static_cast<long>(lines));
+		BENCH_TIME(lines = Insert(text, SC_LINE_END_TYPE_UNICODE),
+			"insert %zu MB, %s, Unicode line ends (%ld lines)", text.length() >> 20, kind,
+			static_cast<long>(lines));
+	}
+	return EXIT_SUCCESS;
+}
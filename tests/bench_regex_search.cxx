@@ -0,0 +1,154 @@
+/*
+ *      bench_regex_search.cxx - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Times regular expression searches in Scintilla's Document, as done by find next
+ * and replace all. Build it with "make -C tests bench_regex_search" and run it on
+ * two revisions to compare them; see tests/Makefile.am. Like Geany's Scintilla it is
+ * built with NO_CXX11_REGEX there, so the std::regex searches are only timed when
+ * building it by hand without that.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <forward_list>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+
+#include "Platform.h"
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+
+#include "bench_utils.h"
+
+using namespace Scintilla;
+
+namespace {
+
+const size_t documentSize = 20 * 1024 * 1024;
+const int findNextCount = 20000;
+
+// Lines of random lower case words, with a "w<digits>x" word now and then for the
+// searches to find. utf8 adds two byte characters to the words.
+std::string MakeText(bool utf8) {
+	BenchRandom random;
+	std::string text;
+	text.reserve(documentSize + 100);
+	while (text.size() < documentSize) {
+		const unsigned int words = 4 + random.Next(8);
+		for (unsigned int w = 0; w < words; w++) {
+			if (random.Next(50) == 0) {
+				text += "w" + std::to_string(random.Next(1000)) + "x";
+			} else {
+				const unsigned int letters = 1 + random.Next(9);
+				for (unsigned int l = 0; l < letters; l++) {
+					if (utf8 && (random.Next(20) == 0)) {
+						text += "\xc3\xa9";
+					} else {
+						text += static_cast<char>('a' + random.Next(26));
+					}
+				}
+			}
+			text += ' ';
+		}
+		text += '\n';
+	}
+	return text;
+}
+
+std::unique_ptr<Document> MakeDocument(const std::string &text, bool utf8) {
+	std::unique_ptr<Document> doc(new Document(SC_DOCUMENTOPTION_DEFAULT));
+	doc->SetDBCSCodePage(utf8 ? SC_CP_UTF8 : 0);
+	doc->InsertString(0, text.c_str(), text.length());
+	// Move the gap into the middle like after editing there
+	doc->InsertString(text.length() / 2, "a", 1);
+	return doc;
+}
+
+// Finds pattern findNextCount times, each time after the previous match, starting
+// over at the end of the document. Returns the number of matches.
+int FindNext(Document *doc, const char *pattern, int flags) {
+	int found = 0;
+	Sci::Position pos = 0;
+	for (int i = 0; i < findNextCount; i++) {
+		Sci::Position length = strlen(pattern);
+		const Sci::Position match = doc->FindText(pos, doc->Length(), pattern, flags, &length);
+		if (match < 0) {
+			pos = 0;
+		} else {
+			found++;
+			pos = match + std::max<Sci::Position>(length, 1);
+		}
+	}
+	return found;
+}
+
+// Searches the whole document for pattern count times.
+int Scan(Document *doc, const char *pattern, int flags, int count) {
+	int found = 0;
+	for (int i = 0; i < count; i++) {
+		Sci::Position length = strlen(pattern);
+		if (doc->FindText(0, doc->Length(), pattern, flags, &length) >= 0)
+			found++;
+	}
+	return found;
+}
+
+}
+
+int main() {
+	for (int utf8 = 0; utf8 <= 1; utf8++) {
+		const std::string text = MakeText(utf8 != 0);
+		std::unique_ptr<Document> doc = MakeDocument(text, utf8 != 0);
+		const char *encoding = utf8 ? "UTF-8" : "8-bit";
+		int found = 0;
+
+#ifndef NO_CXX11_REGEX
+		BENCH_TIME(found = FindNext(doc.get(), "w[0-9]+x", SCFIND_REGEXP | SCFIND_CXX11REGEX),
+			"%d find next, std::regex, %s text (%d found)", findNextCount, encoding, found);
+#endif
+		BENCH_TIME(found = FindNext(doc.get(), "w[0-9]+x", SCFIND_REGEXP | SCFIND_POSIX),
+			"%d find next, RESearch, %s text (%d found)", findNextCount, encoding, found);
+		BENCH_TIME(found = Scan(doc.get(), "zqxjzq[a-z]", SCFIND_REGEXP | SCFIND_MATCHCASE, 10),
+			"10 scans for an absent literal, RESearch, %s text (%d found)", encoding, found);
+		BENCH_TIME(found = Scan(doc.get(), "[0-9]q[0-9]", SCFIND_REGEXP | SCFIND_MATCHCASE, 10),
+			"10 scans for an absent class, RESearch, %s text (%d found)", encoding, found);
+		BENCH_TIME(found = Scan(doc.get(), "ZQXJZQ[a-z]", SCFIND_REGEXP, 10),
+			"10 caseless scans, RESearch, %s text (%d found)", encoding, found);
+	}
+	return EXIT_SUCCESS;
+}
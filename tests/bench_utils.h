@@ -0,0 +1,75 @@
+/*
+ *      bench_utils.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Helpers for the benchmarks, mostly of Scintilla internals, which are built from
+ * Scintilla's sources without the GTK platform layer. */
+
+#ifndef GEANY_BENCH_UTILS_H
+#define GEANY_BENCH_UTILS_H 1
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+
+#include "Platform.h"
+
+namespace Scintilla {
+
+void Platform::DebugPrintf(const char *, ...) {
+}
+
+void Platform::Assert(const char *c, const char *file, int line) {
+	std::fprintf(stderr, "Assertion [%s] failed at %s %d\n", c, file, line);
+	std::abort();
+}
+
+}
+
+/* Same sequence on every run and platform, unlike rand() */
+class BenchRandom {
+	unsigned int state = 2463534242u;
+public:
+	unsigned int Next(unsigned int range) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state % range;
+	}
+};
+
+/* Runs statement three times and prints the shortest time in milliseconds followed by
+ * the printf() style description, which may use the results of statement. */
+#define BENCH_TIME(statement, ...) \
+	do { \
+		double best_ = 0; \
+		for (int run_ = 0; run_ < 3; run_++) { \
+			const auto start_ = std::chrono::steady_clock::now(); \
+			statement; \
+			const std::chrono::duration<double, std::milli> ms_ = std::chrono::steady_clock::now() - start_; \
+			best_ = (run_ == 0) ? ms_.count() : std::min(best_, ms_.count()); \
+		} \
+		std::printf("%9.1f ms  ", best_); \
+		std::printf(__VA_ARGS__); \
+		std::printf("\n"); \
+	} while (0)
+
+#endif
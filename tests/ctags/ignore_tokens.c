@@ -0,0 +1,18 @@
+/* the identifiers below are listed in ignore_tokens.c.ignore, which is used
+ * as ignore.tags while parsing this file */
+
+struct exact {
+	MY_API int a;
+};
+
+struct parens {
+	MY_DEPRECATED("use a") int b;
+};
+
+struct wildcard {
+	G_GNUC_CONST int c;
+};
+
+MY_STRUCT replaced {
+	int d;
+};
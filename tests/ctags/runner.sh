@@ -33,5 +33,10 @@ shift
 
 tagfile="$TMPDIR/test.${source##*.}.tags"
 
+# a $source.ignore file is used as the C/C++ ignore.tags list
+if [ -f "$source.ignore" ]; then
+  cp "$source.ignore" "$CONFDIR/ignore.tags" || exit 99
+fi
+
 "$GEANY" -c "$CONFDIR" -P -g "$tagfile" "$source" "$@" || exit 1
 diff -u "$result" "$tagfile" || exit 2
@@ -0,0 +1,144 @@
+/*
+ *      test_sci_document.cxx - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Checks of the documents Geany creates through its own additions to Scintilla, like
+ * documents showing external text and cloned documents, built from Scintilla's sources
+ * without the GTK platform layer.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <forward_list>
+#include <algorithm>
+#include <memory>
+
+#include "Platform.h"
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "CharacterCategory.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+
+#include "bench_utils.h"
+
+using namespace Scintilla;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			failures++; \
+		} \
+	} while (0)
+
+const char text[] = "hello world\nsecond line\n";
+const int indicator = 8;
+
+Document *NewDocument() {
+	Document *doc = new Document(SC_DOCUMENTOPTION_DEFAULT);
+	doc->AddRef();
+	return doc;
+}
+
+/* Fills "world" with an indicator and checks it covers just that word, before and
+ * after inserting text in front of it. */
+void CheckIndicatorFill(Document *doc) {
+	doc->DecorationSetCurrentIndicator(indicator);
+	doc->DecorationFillRange(6, 1, 5);
+	CHECK(doc->decorations->ValueAt(indicator, 5) == 0);
+	CHECK(doc->decorations->ValueAt(indicator, 6) == 1);
+	CHECK(doc->decorations->ValueAt(indicator, 10) == 1);
+	CHECK(doc->decorations->ValueAt(indicator, 11) == 0);
+	doc->InsertString(0, "> ", 2);
+	CHECK(doc->decorations->ValueAt(indicator, 7) == 0);
+	CHECK(doc->decorations->ValueAt(indicator, 8) == 1);
+	CHECK(doc->decorations->ValueAt(indicator, 12) == 1);
+	CHECK(doc->decorations->ValueAt(indicator, 13) == 0);
+}
+
+void TestClone() {
+	Document *source = NewDocument();
+	source->InsertString(0, text, strlen(text));
+	Document *clone = NewDocument();
+	source->ShareText(*clone);
+	CHECK(clone->Length() == source->Length());
+	CHECK(!source->HasExternalText());
+	CHECK(!clone->HasExternalText());
+	/* converting line ends that are already right keeps sharing the text */
+	clone->ConvertLineEnds(SC_EOL_LF);
+	CHECK(clone->BufferPointer() == source->BufferPointer());
+	clone->ConvertLineEnds(SC_EOL_CRLF);
+	CHECK(clone->BufferPointer() != source->BufferPointer());
+	CHECK(clone->Length() == source->Length() + 2);
+	CheckIndicatorFill(clone);
+	CheckIndicatorFill(source);
+	clone->Release();
+	source->Release();
+}
+
+void TestCloneExternalText() {
+	Document *source = NewDocument();
+	source->SetExternalText(text, strlen(text), nullptr, nullptr);
+	Document *clone = NewDocument();
+	source->ShareText(*clone);
+	CHECK(source->HasExternalText());
+	CHECK(clone->HasExternalText());
+	CheckIndicatorFill(clone);
+	CHECK(!clone->HasExternalText());
+	CHECK(source->HasExternalText());
+	clone->Release();
+	source->Release();
+}
+
+void TestExternalText() {
+	Document *doc = NewDocument();
+	doc->SetExternalText(text, strlen(text), nullptr, nullptr);
+	CHECK(doc->Length() == static_cast<Sci::Position>(strlen(text)));
+	CHECK(doc->HasExternalText());
+	CheckIndicatorFill(doc);
+	doc->Release();
+}
+
+}
+
+int main() {
+	TestExternalText();
+	TestClone();
+	TestCloneExternalText();
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+/*
+ *      test_tm_source_file.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "tm_source_file.h"
+#include "tm_tag.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#define TM_TEST_ADD(path, func) g_test_add_func("/tm_source_file/" path, func);
+
+
+/* Reads tags_file and writes it back to a temporary file, returning the
+ * contents of the latter. */
+static gchar *round_trip(const gchar *tags_file)
+{
+	GPtrArray *tags;
+	gchar *out_file, *contents;
+	gint fd;
+
+	tags = tm_source_file_read_tags_file(tags_file, TM_PARSER_NONE);
+	g_assert_nonnull(tags);
+
+	fd = g_file_open_tmp("test-tm-source-file-XXXXXX", &out_file, NULL);
+	g_assert_cmpint(fd, >=, 0);
+	close(fd);
+
+	g_assert_true(tm_source_file_write_tags_file(out_file, tags));
+	g_assert_true(g_file_get_contents(out_file, &contents, NULL, NULL));
+
+	g_unlink(out_file);
+	g_free(out_file);
+	tm_tags_array_free(tags, TRUE);
+
+	return contents;
+}
+
+/* Only ASCII files are checked as the tagmanager format cannot represent bytes
+ * >= 200 inside values, which are used as field markers. */
+static gboolean is_round_trippable(const gchar *contents, gsize length)
+{
+	gsize i;
+
+	if (!g_str_has_prefix(contents, "# format=tagmanager\n"))
+		return FALSE;
+	for (i = 0; i < length; i++)
+	{
+		if ((guchar) contents[i] >= 0x80)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void round_trip_dir(const gchar *path, guint *count)
+{
+	GDir *dir = g_dir_open(path, 0, NULL);
+	const gchar *name;
+
+	g_assert_nonnull(dir);
+	while ((name = g_dir_read_name(dir)) != NULL)
+	{
+		gchar *child = g_build_filename(path, name, NULL);
+		gchar *expected, *result;
+		gsize length;
+
+		if (g_file_test(child, G_FILE_TEST_IS_DIR))
+			round_trip_dir(child, count);
+		else if (g_str_has_suffix(name, ".tags") &&
+			g_file_get_contents(child, &expected, &length, NULL))
+		{
+			if (is_round_trippable(expected, length))
+			{
+				result = round_trip(child);
+				g_assert_cmpstr(result, ==, expected);
+				g_free(result);
+				(*count)++;
+			}
+			g_free(expected);
+		}
+		g_free(child);
+	}
+	g_dir_close(dir);
+}
+
+static void test_tm_source_file_round_trip(void)
+{
+	guint count = 0;
+
+	round_trip_dir(TAGS_TEST_DIR, &count);
+	g_assert_cmpuint(count, >, 0);
+}
+
+static void test_tm_source_file_long_lines(void)
+{
+	GString *contents = g_string_new("# format=tagmanager\n");
+	gchar *tags_file, *result;
+	gint fd;
+	guint i;
+
+	/* lines much longer than any fixed size read buffer */
+	for (i = 0; i < 3; i++)
+	{
+		gchar *arglist = g_strnfill(100000 * (i + 1), 'a' + i);
+
+		g_string_append_printf(contents, "name%u\xcc%u\xcd(%s)\xce" "Scope\xd6%u\n",
+			i, 16 << i, arglist, i);
+		g_free(arglist);
+	}
+
+	fd = g_file_open_tmp("test-tm-source-file-XXXXXX", &tags_file, NULL);
+	g_assert_cmpint(fd, >=, 0);
+	close(fd);
+	g_assert_true(g_file_set_contents(tags_file, contents->str, contents->len, NULL));
+
+	result = round_trip(tags_file);
+	g_assert_cmpstr(result, ==, contents->str);
+
+	g_unlink(tags_file);
+	g_free(tags_file);
+	g_free(result);
+	g_string_free(contents, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	TM_TEST_ADD("round_trip", test_tm_source_file_round_trip);
+	TM_TEST_ADD("long_lines", test_tm_source_file_long_lines);
+
+	return g_test_run();
+}
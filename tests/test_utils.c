@@ -1,5 +1,6 @@
 
 #include "utils.h"
+#include "Scintilla.h"
 
 #include "gtkcompat.h"
 
@@ -408,6 +409,35 @@ void test_utils_strv_shorten_file_list(void)
 	g_strfreev(data);
 }
 
+static void test_utils_count_line_endings(void)
+{
+	const gchar *data[] = {
+		"", "a", "a\n", "a\r\nb\r\n", "a\rb\r", "\r\r\n\n", "a\r\nb\nc\n", "\r\n\r\r\r"
+	};
+	guint i;
+
+	g_assert_cmpint(utils_get_line_endings("", 0), ==, SC_EOL_LF);
+	g_assert_cmpint(utils_get_line_endings("a\nb\r\nc\r\n", 9), ==, SC_EOL_CRLF);
+	g_assert_cmpint(utils_get_line_endings("a\rb\r", 4), ==, SC_EOL_CR);
+
+	/* counting in pieces gives the same result as counting at once */
+	for (i = 0; i < G_N_ELEMENTS(data); i++)
+	{
+		gsize len = strlen(data[i]);
+		gint expected = utils_get_line_endings(data[i], len);
+		gsize split;
+
+		for (split = 0; split <= len; split++)
+		{
+			GeanyLineEndingCounts counts = { 0 };
+
+			utils_count_line_endings(&counts, data[i], split);
+			utils_count_line_endings(&counts, data[i] + split, len - split);
+			g_assert_cmpint(utils_get_line_endings_from_counts(&counts), ==, expected);
+		}
+	}
+}
+
 int main(int argc, char **argv)
 {
 	g_test_init(&argc, &argv, NULL);
@@ -416,6 +446,7 @@ int main(int argc, char **argv)
 	UTIL_TEST_ADD("strv_find_common_prefix", test_utils_strv_find_common_prefix);
 	UTIL_TEST_ADD("strv_find_lcs", test_utils_strv_find_lcs);
 	UTIL_TEST_ADD("strv_shorten_file_list", test_utils_strv_shorten_file_list);
+	UTIL_TEST_ADD("count_line_endings", test_utils_count_line_endings);
 
 	return g_test_run();
 }